@@ -0,0 +1,107 @@
+// Compares the runtime allocators against malloc/free.
+// Usage: ulang_alloc_bench [iterations] [threads]
+#include <allocator.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace UraniumLang;
+
+namespace {
+
+  constexpr size_t ObjectsPerFrame = 4096;
+  constexpr size_t Sizes[] = { 16, 24, 48, 64, 96, 128, 256, 512 };
+  constexpr size_t NumSizes = sizeof(Sizes) / sizeof(Sizes[0]);
+
+  // Keeps the compiler from dropping the allocations
+  volatile uintptr_t Sink = 0;
+
+  double measure(size_t threads, const std::function<void()> &body) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers{};
+    for (size_t i = 1; i < threads; ++i) workers.emplace_back(body);
+    body();
+    for (auto &worker : workers) worker.join();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void report(const char *name, double ms, double baseline, size_t ops) {
+    std::printf("  %-22s %10.2f ms  %8.2f ns/op  %6.2fx\n", name, ms, ms * 1e6 / ops, baseline / ms);
+  }
+
+}
+
+int main(int argc, char **argv) {
+  size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  if (threads == 0) threads = 1;
+  size_t ops = frames * ObjectsPerFrame * threads;
+
+  std::printf("%zu frames x %zu objects, %zu thread(s)\n", frames, ObjectsPerFrame, threads);
+
+  // Per-frame allocations: everything allocated during a frame dies at its end
+  double mallocMs = measure(threads, [&]() {
+    std::vector<void*> live(ObjectsPerFrame);
+    for (size_t f = 0; f < frames; ++f) {
+      for (size_t i = 0; i < ObjectsPerFrame; ++i) live[i] = std::malloc(Sizes[i % NumSizes]);
+      Sink = Sink + (uintptr_t)live[f % ObjectsPerFrame];
+      for (auto ptr : live) std::free(ptr);
+    }
+  });
+
+  double allocMs = measure(threads, [&]() {
+    std::vector<void*> live(ObjectsPerFrame);
+    for (size_t f = 0; f < frames; ++f) {
+      for (size_t i = 0; i < ObjectsPerFrame; ++i) live[i] = Alloc::Allocate(Sizes[i % NumSizes]);
+      Sink = Sink + (uintptr_t)live[f % ObjectsPerFrame];
+      for (auto ptr : live) Alloc::Deallocate(ptr);
+    }
+    Alloc::FlushThreadCache();
+  });
+
+  double arenaMs = measure(threads, [&]() {
+    FrameArena arena{};
+    for (size_t f = 0; f < frames; ++f) {
+      void *last = nullptr;
+      for (size_t i = 0; i < ObjectsPerFrame; ++i) last = arena.Alloc(Sizes[i % NumSizes]);
+      Sink = Sink + (uintptr_t)last;
+      arena.Reset();
+    }
+  });
+
+  double poolMs = measure(threads, [&]() {
+    Pool pool(64);
+    std::vector<void*> live(ObjectsPerFrame);
+    for (size_t f = 0; f < frames; ++f) {
+      for (size_t i = 0; i < ObjectsPerFrame; ++i) live[i] = pool.Alloc();
+      Sink = Sink + (uintptr_t)live[f % ObjectsPerFrame];
+      for (auto ptr : live) pool.Free(ptr);
+    }
+  });
+
+  double mallocFixedMs = measure(threads, [&]() {
+    std::vector<void*> live(ObjectsPerFrame);
+    for (size_t f = 0; f < frames; ++f) {
+      for (size_t i = 0; i < ObjectsPerFrame; ++i) live[i] = std::malloc(64);
+      Sink = Sink + (uintptr_t)live[f % ObjectsPerFrame];
+      for (auto ptr : live) std::free(ptr);
+    }
+  });
+
+  std::printf("Mixed sizes (16..512 bytes):\n");
+  report("malloc/free", mallocMs, mallocMs, ops);
+  report("Alloc (thread cache)", allocMs, mallocMs, ops);
+  report("FrameArena", arenaMs, mallocMs, ops);
+  std::printf("Fixed size (64 bytes):\n");
+  report("malloc/free", mallocFixedMs, mallocFixedMs, ops);
+  report("Pool", poolMs, mallocFixedMs, ops);
+
+  auto stats = GetAllocStats();
+  std::printf("Alloc stats: %zu allocations, %zu frees, %zu bytes in use, %zu bytes peak reserved\n",
+              stats.Allocations, stats.Frees, stats.BytesInUse, stats.PeakBytes);
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Scaling of the job system from 1 to N threads.
+// Usage: ulang_jobs_bench [max threads] [entities] [frames]
+#include <jobs.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace UraniumLang;
+
+namespace {
+
+  struct Entities {
+    std::vector<double> X, Y, VX, VY;
+
+    Entities(size_t count) : X(count), Y(count), VX(count), VY(count) {
+      for (size_t i = 0; i < count; ++i) {
+        X[i] = (double)i;
+        Y[i] = (double)(count - i);
+        VX[i] = std::sin((double)i);
+        VY[i] = std::cos((double)i);
+      }
+    }
+
+    double Checksum() const {
+      double sum = 0.0;
+      for (size_t i = 0; i < X.size(); ++i) sum += X[i] + Y[i];
+      return sum;
+    }
+  };
+
+  // Uneven on purpose, so work stealing has something to balance
+  void updateEntities(int64_t begin, int64_t end, void *arg) {
+    auto &e = *(Entities*)arg;
+    for (int64_t i = begin; i < end; ++i) {
+      int steps = 1 + (int)(i % 7);
+      for (int s = 0; s < steps; ++s) {
+        e.VX[i] += -e.X[i] * 1e-4;
+        e.VY[i] += -e.Y[i] * 1e-4;
+        e.X[i] += e.VX[i] * 1e-2;
+        e.Y[i] += e.VY[i] * 1e-2;
+      }
+    }
+  }
+
+  struct Chain {
+    std::vector<int> Order{};
+  };
+
+  void appendStage(void *arg) {
+    auto &chain = *(Chain*)arg;
+    chain.Order.push_back((int)chain.Order.size());
+  }
+
+  void emptyJob(void *) {}
+
+  double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+}
+
+int main(int argc, char **argv) {
+  size_t maxThreads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+  size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1 << 20;
+  size_t frames = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+  if (maxThreads == 0) maxThreads = 1;
+
+  double expected = 0.0;
+  {
+    Entities serial(count);
+    for (size_t f = 0; f < frames; ++f) updateEntities(0, (int64_t)count, &serial);
+    expected = serial.Checksum();
+  }
+
+  std::printf("%zu entities, %zu frames\n", count, frames);
+  std::printf("  threads  parallel_for ms  speedup  spawn+join ns/job  checksum\n");
+
+  double baseline = 0.0;
+  bool ok = true;
+  for (size_t threads = 1; threads <= maxThreads; ++threads) {
+    JobSystem jobs(threads);
+
+    Entities entities(count);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; ++f) jobs.ParallelFor(0, (int64_t)count, updateEntities, &entities);
+    double pforMs = elapsedMs(start);
+    if (threads == 1) baseline = pforMs;
+
+    constexpr size_t Spawned = 100000;
+    std::vector<Job*> handles(Spawned);
+    start = std::chrono::steady_clock::now();
+    for (auto &handle : handles) {
+      handle = jobs.Create(emptyJob, nullptr);
+      jobs.Submit(handle);
+    }
+    for (auto handle : handles) {
+      jobs.Wait(handle);
+      jobs.Release(handle);
+    }
+    double spawnNs = elapsedMs(start) * 1e6 / Spawned;
+
+    // Each stage depends on the previous one, so they have to run in order
+    Chain chain{};
+    std::vector<Job*> stages(64);
+    for (size_t i = 0; i < stages.size(); ++i) {
+      stages[i] = jobs.Create(appendStage, &chain);
+      if (i > 0) jobs.DependsOn(stages[i], stages[i - 1]);
+    }
+    for (size_t i = stages.size(); i-- > 0;) jobs.Submit(stages[i]);
+    jobs.Wait(stages.back());
+    for (auto stage : stages) jobs.Release(stage);
+    for (size_t i = 0; i < chain.Order.size(); ++i) ok &= chain.Order[i] == (int)i;
+    ok &= chain.Order.size() == stages.size();
+
+    double checksum = entities.Checksum();
+    ok &= checksum == expected;
+    std::printf("  %7zu  %15.2f  %6.2fx  %17.1f  %s\n", threads, pforMs, baseline / pforMs, spawnNs,
+                checksum == expected ? "ok" : "MISMATCH");
+  }
+
+  if (!ok) std::fprintf(stderr, "Job system produced wrong results!\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#include <cstdio>
+
+static double a[65536];
+static double b[65536];
+static double c[65536];
+
+int main() {
+  for (int i = 0; i < 256; ++i) {
+    for (int j = 0; j < 256; ++j) {
+      a[i * 256 + j] = (i + j) / 256.0;
+      b[i * 256 + j] = (i - j) / 256.0;
+      c[i * 256 + j] = 0;
+    }
+  }
+
+  for (int rep = 0; rep < 16; ++rep) {
+    for (int i = 0; i < 256; ++i) {
+      for (int k = 0; k < 256; ++k) {
+        double aik = a[i * 256 + k];
+        for (int j = 0; j < 256; ++j) c[i * 256 + j] = c[i * 256 + j] + aik * b[k * 256 + j];
+      }
+    }
+  }
+
+  double checksum = 0;
+  for (int i = 0; i < 65536; ++i) checksum = checksum + c[i];
+  std::printf("%.17g\n", checksum);
+}
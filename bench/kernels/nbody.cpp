@@ -0,0 +1,50 @@
+#include <cmath>
+#include <cstdio>
+
+struct Body {
+  double x, y, z;
+  double vx, vy, vz;
+  double m;
+};
+
+static Body bodies[1024];
+
+int main() {
+  for (int i = 0; i < 1024; ++i) {
+    bodies[i].x = i / 1024.0;
+    bodies[i].y = ((double)i * i) / 1048576.0 - 0.5;
+    bodies[i].z = (1024 - i) / 2048.0;
+    bodies[i].vx = 0;
+    bodies[i].vy = 0;
+    bodies[i].vz = 0;
+    bodies[i].m = 1 / 1024.0;
+  }
+
+  for (int step = 0; step < 40; ++step) {
+    for (int i = 0; i < 1024; ++i) {
+      double ax = 0, ay = 0, az = 0;
+      for (int j = 0; j < 1024; ++j) {
+        double dx = bodies[j].x - bodies[i].x;
+        double dy = bodies[j].y - bodies[i].y;
+        double dz = bodies[j].z - bodies[i].z;
+        double d2 = dx * dx + dy * dy + dz * dz + 0.0001;
+        double s = bodies[j].m / (d2 * std::sqrt(d2));
+        ax = ax + dx * s;
+        ay = ay + dy * s;
+        az = az + dz * s;
+      }
+      bodies[i].vx = bodies[i].vx + ax * 0.001;
+      bodies[i].vy = bodies[i].vy + ay * 0.001;
+      bodies[i].vz = bodies[i].vz + az * 0.001;
+    }
+    for (int i = 0; i < 1024; ++i) {
+      bodies[i].x = bodies[i].x + bodies[i].vx * 0.001;
+      bodies[i].y = bodies[i].y + bodies[i].vy * 0.001;
+      bodies[i].z = bodies[i].z + bodies[i].vz * 0.001;
+    }
+  }
+
+  double checksum = 0;
+  for (int i = 0; i < 1024; ++i) checksum = checksum + bodies[i].x + bodies[i].y + bodies[i].z;
+  std::printf("%.17g\n", checksum);
+}
@@ -0,0 +1,28 @@
+#include <cstdio>
+
+// Same layout as the ULang soa struct, one array per field
+static double x[262144];
+static double y[262144];
+static double vx[262144];
+static double vy[262144];
+
+int main() {
+  for (int i = 0; i < 262144; ++i) {
+    x[i] = 0;
+    y[i] = i / 262144.0;
+    vx[i] = 1 + i / 524288.0;
+    vy[i] = 0;
+  }
+
+  for (int frame = 0; frame < 200; ++frame) {
+    for (int i = 0; i < 262144; ++i) {
+      vy[i] = vy[i] - 9.81 * 0.016;
+      x[i] = x[i] + vx[i] * 0.016;
+      y[i] = y[i] + vy[i] * 0.016;
+    }
+  }
+
+  double checksum = 0;
+  for (int i = 0; i < 262144; ++i) checksum = checksum + x[i] + y[i];
+  std::printf("%.17g\n", checksum);
+}
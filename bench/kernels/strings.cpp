@@ -0,0 +1,16 @@
+#include <cstdio>
+#include <string>
+
+int main() {
+  std::string s{};
+
+  for (int i = 0; i < 200000; ++i) {
+    char buf[32];
+    s += "item ";
+    std::snprintf(buf, sizeof(buf), "%g", (double)i);
+    s += buf;
+    s += ", ";
+  }
+
+  std::printf("%.17g\n", (double)s.size());
+}
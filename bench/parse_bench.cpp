@@ -0,0 +1,148 @@
+// Lexer + parser throughput on clean input and on input where every n-th statement is broken,
+// the common case for half-typed files in an editor.
+// Also streams a large generated file through the parser to show memory use stays flat.
+// Usage: ulang_parse_bench [statements] [repeats] [streamed MB]
+#include <astfile.h>
+#include <parser.h>
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace UraniumLang;
+
+namespace {
+
+  // Mix of the statements ULang has, errorEvery = 0 for a clean file
+  std::string generate(size_t statements, size_t errorEvery) {
+    static const char *Clean[] = {
+      "double a = 1 + 2 * (3 - 4);\n",
+      "a = a * 0.5 + 2;\n",
+      "for (i = 0 : 16) { a = a + i; }\n",
+      "struct P { double x; double y; };\n",
+      "print(a);\n",
+      "str_append(s, \"long enough to cross small lexer chunks\");\n",
+    };
+    static const char *Broken[] = {
+      "double b = 1 + ;\n",         // Missing operand
+      "a = (a * 2;\n",              // Missing parenthesis
+      "for (i = 0 : ) { a = ; }\n", // Broken header and body
+      "double c = 3 $ 4;\n",        // Unknown character
+      "}\n",                        // Stray brace
+    };
+
+    std::string src{};
+    for (size_t i = 0; i < statements; ++i) {
+      if (errorEvery && i % errorEvery == errorEvery - 1) src += Broken[(i / errorEvery) % 5];
+      else src += Clean[i % (sizeof(Clean) / sizeof(Clean[0]))];
+    }
+    return src;
+  }
+
+  void run(const char *name, const std::string &src, size_t repeats) {
+    size_t diagnostics = 0, statements = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeats; ++r) {
+      auto lexer = std::make_unique<Lexer>();
+      lexer->SetContent(src);
+      Parser parser(std::move(lexer));
+      auto prog = parser.Parse();
+      diagnostics = parser.GetDiagnostics().size();
+      statements = prog->GetStatements().size();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    std::printf("  %-18s %9.2f ms  %8.2f MB/s  %8zu statements  %8zu diagnostics\n", name, ms,
+                src.size() / (ms * 1e3), statements, diagnostics);
+  }
+
+  size_t countNodes(const ASTNode &node) {
+    size_t count = 1;
+    for (size_t i = 0; i < node.GetChildCount(); ++i)
+      if (auto child = node.GetChild(i)) count += countNodes(child);
+    return count;
+  }
+
+  // Loading a binary AST written by an earlier parse, what tools sharing a cache would do
+  void loadCached(const std::string &src, size_t repeats) {
+    auto lexer = std::make_unique<Lexer>();
+    lexer->SetContent(src);
+    auto data = SerializeAST(Parser(std::move(lexer)).Parse().get());
+
+    size_t nodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeats; ++r) {
+      ASTView view{};
+      if (!view.Open(data.data(), data.size())) return;
+      nodes = countNodes(view.GetRoot());
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    std::printf("  %-18s %9.2f ms  %8.2f MB/s  %8zu nodes  %8zu KB binary AST\n", "clean, cached AST", ms,
+                src.size() / (ms * 1e3), nodes, data.size() >> 10);
+  }
+
+  size_t peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+  // Runs first, before anything else could raise the peak.
+  // The file is parsed again in tiny chunks, so most tokens cross a chunk boundary,
+  // false if that changes the result
+  bool stream(size_t megabytes) {
+    auto path = std::filesystem::temp_directory_path() / "ulang_parse_bench.ulang";
+    {
+      std::ofstream file(path, std::ios::binary);
+      std::string block = generate(10000, 0); // Clean, diagnostics are kept and would grow
+      for (size_t written = 0; written < megabytes << 20; written += block.size()) file << block;
+    }
+    size_t size = std::filesystem::file_size(path), rssBefore = peakRssKb();
+    std::printf("Streamed %zu MB file:\n", size >> 20);
+
+    size_t results[2][2]{}; // statements, diagnostics
+    const size_t ChunkSizes[] = { Lexer::DefaultChunkSize, 7 };
+    for (size_t i = 0; i < 2; ++i) {
+      size_t statements = 0;
+      auto start = std::chrono::steady_clock::now();
+      Parser parser(std::make_unique<Lexer>(path.string(), ChunkSizes[i]));
+      parser.Parse([&](uptr<StmtNode> stmt) { statements++; });
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      results[i][0] = statements;
+      results[i][1] = parser.GetDiagnostics().size();
+
+      std::printf("  %-18s %9.2f ms  %8.2f MB/s  %8zu statements  %8zu diagnostics\n",
+                  (std::to_string(ChunkSizes[i]) + " B chunks").c_str(), ms, size / (ms * 1e3), results[i][0], results[i][1]);
+      if (i == 0) std::printf("  peak RSS %zu KB before, %zu KB after\n", rssBefore, peakRssKb());
+    }
+    std::filesystem::remove(path);
+
+    if (results[0][1] != 0 || results[0][0] != results[1][0] || results[0][1] != results[1][1]) {
+      std::printf("  FAILED: chunked lexing changed the result\n");
+      return false;
+    }
+    return true;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  size_t statements = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  size_t repeats = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+  size_t streamMb = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 8;
+  if (repeats == 0) repeats = 1;
+
+  if (streamMb && !stream(streamMb)) return 1;
+
+  std::printf("%zu statements, average of %zu parse(s)\n", statements, repeats);
+  run("clean", generate(statements, 0), repeats);
+  loadCached(generate(statements, 0), repeats);
+  run("1 error / 100", generate(statements, 100), repeats);
+  run("1 error / 10", generate(statements, 10), repeats);
+  run("1 error / 2", generate(statements, 2), repeats);
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Runs every kernel compiled from ULang and from the equivalent C++ source,
+// compares their checksums, runtimes and code size.
+// Usage: ulang_runtime_bench [--runs N] [--max-ratio R] <manifest>
+//   manifest: one kernel per line, "<name> <ulang exe> <c++ exe> <ulang object> <c++ object> [max ratio]"
+//   --max-ratio: exit with 1 if a kernel runs more than R times slower than its C++ version,
+//                a max ratio in the manifest takes precedence for its kernel
+#include "llvm/Object/ObjectFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  struct Kernel {
+    std::string Name{};
+    std::string Exe[2]{};    // ULang, C++
+    std::string Object[2]{}; // ULang, C++
+    double MaxRatio = 0;     // 0 = --max-ratio
+  };
+
+  struct Run {
+    bool Ok = false;
+    double Ms = 0;
+    std::string Output{};
+  };
+
+  // Best of runs, so background noise only ever makes a kernel look faster than it is
+  Run run(const std::string &exe, int runs) {
+    Run best{};
+    for (int i = 0; i < runs; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      FILE *pipe = popen(exe.c_str(), "r");
+      if (!pipe) return {};
+
+      std::string output{};
+      char buf[256];
+      while (size_t n = fread(buf, 1, sizeof(buf), pipe)) output.append(buf, n);
+      int status = pclose(pipe);
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (status != 0) return {};
+
+      if (!best.Ok || ms < best.Ms) best.Ms = ms;
+      best.Ok = true;
+      best.Output = output;
+    }
+    return best;
+  }
+
+  bool sameChecksum(const std::string &a, const std::string &b) {
+    char *endA = nullptr, *endB = nullptr;
+    double x = std::strtod(a.c_str(), &endA), y = std::strtod(b.c_str(), &endB);
+    if (endA == a.c_str() || endB == b.c_str()) return a == b;
+    return std::fabs(x - y) <= 1e-9 * std::max({ 1.0, std::fabs(x), std::fabs(y) });
+  }
+
+  // Size of all executable sections, 0 if the object can't be read
+  uint64_t codeSize(const std::string &path) {
+    auto obj = llvm::object::ObjectFile::createObjectFile(path);
+    if (!obj) {
+      llvm::consumeError(obj.takeError());
+      return 0;
+    }
+
+    uint64_t size = 0;
+    for (auto &section : obj->getBinary()->sections())
+      if (section.isText()) size += section.getSize();
+    return size;
+  }
+
+  std::string firstLine(const std::string &str) {
+    return str.substr(0, str.find('\n'));
+  }
+
+}
+
+int main(int argc, char **argv) {
+  int runs = 5;
+  double maxRatio = 0;
+  const char *manifest = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) runs = std::max(1, atoi(argv[++i]));
+    else if (strcmp(argv[i], "--max-ratio") == 0 && i + 1 < argc) maxRatio = atof(argv[++i]);
+    else manifest = argv[i];
+  }
+  if (!manifest) {
+    std::fprintf(stderr, "Usage: %s [--runs N] [--max-ratio R] <manifest>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<Kernel> kernels{};
+  std::ifstream file(manifest);
+  for (std::string line; std::getline(file, line);) {
+    std::istringstream fields(line);
+    Kernel kernel{};
+    if (!(fields >> kernel.Name >> kernel.Exe[0] >> kernel.Exe[1] >> kernel.Object[0] >> kernel.Object[1])) continue;
+    if (!(fields >> kernel.MaxRatio)) kernel.MaxRatio = 0;
+    kernels.push_back(kernel);
+  }
+  if (kernels.empty()) {
+    std::fprintf(stderr, "No kernels found in \"%s\"!\n", manifest);
+    return 2;
+  }
+
+  std::printf("best of %d run(s)\n", runs);
+  std::printf("  %-12s %12s %12s %8s %12s %12s %8s\n", "kernel", "ulang ms", "c++ ms", "ratio", "ulang .text", "c++ .text", "ratio");
+
+  bool failed = false;
+  for (auto &kernel : kernels) {
+    Run ulang = run(kernel.Exe[0], runs), cpp = run(kernel.Exe[1], runs);
+    if (!ulang.Ok || !cpp.Ok) {
+      std::printf("  %-12s failed to run %s\n", kernel.Name.c_str(), (!ulang.Ok ? kernel.Exe[0] : kernel.Exe[1]).c_str());
+      failed = true;
+      continue;
+    }
+
+    uint64_t ulangSize = codeSize(kernel.Object[0]), cppSize = codeSize(kernel.Object[1]);
+    double ratio = ulang.Ms / std::max(cpp.Ms, 1e-3);
+    std::printf("  %-12s %12.2f %12.2f %7.2fx %12llu %12llu %7.2fx\n", kernel.Name.c_str(), ulang.Ms, cpp.Ms, ratio,
+                (unsigned long long)ulangSize, (unsigned long long)cppSize, cppSize ? (double)ulangSize / cppSize : 0.0);
+
+    if (!sameChecksum(ulang.Output, cpp.Output)) {
+      std::printf("  %-12s checksum mismatch: %s (ulang) vs %s (c++)\n", kernel.Name.c_str(),
+                  firstLine(ulang.Output).c_str(), firstLine(cpp.Output).c_str());
+      failed = true;
+    }
+    double limit = kernel.MaxRatio > 0 ? kernel.MaxRatio : maxRatio;
+    if (limit > 0 && ratio > limit) {
+      std::printf("  %-12s slower than the allowed %.2fx\n", kernel.Name.c_str(), limit);
+      failed = true;
+    }
+  }
+
+  return failed ? 1 : 0;
+}
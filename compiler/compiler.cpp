@@ -1,5 +1,9 @@
 #include "compiler.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
 #include <filesystem>
 
 namespace UraniumLang {
@@ -10,6 +14,8 @@ namespace UraniumLang {
       { "--h",       "Display this information." },
       { "--v",       "Display version." },
       { "-o <file>", "Place the output into <file>." },
+      { "-O<level>", "Optimization level 0-3 (default: 0)." },
+      { "-emit-ast <file>", "Also write the parsed program as binary AST to <file>." },
     };
 
     std::stringstream msg("");
@@ -40,6 +46,17 @@ namespace UraniumLang {
           Help(options, argv[0]);
           break;
         }
+        else if (strlen(argv[i]) == 3 && strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '3') {
+          options.OptLevel = argv[i][2] - '0';
+        }
+        else if (strcmp(argv[i], "-emit-ast") == 0) {
+          if (i + 1 < (size_t)argc) {
+            options.ASTOutput = argv[++i];
+          } else {
+            Help(options, argv[0]);
+            break;
+          }
+        }
         else if (strcmp(argv[i], "-o") == 0) {
           if (i < argc) {
             options.Output = argv[++i];
@@ -63,7 +80,7 @@ namespace UraniumLang {
   }
 
   std::vector<CompilationError> Generator::Generate(CompilerOptions options) {
-    std::vector<CompilationError> errors{};
+    m_Errors.clear();
 
     auto TargetTriple = sys::getDefaultTargetTriple();
     InitializeAllTargetInfos();
@@ -76,114 +93,553 @@ namespace UraniumLang {
     auto Target = TargetRegistry::lookupTarget(TargetTriple, Error);
 
     if (!Target) {
-      errs() << Error;
-      return errors;
+      error(Error);
+      return m_Errors;
     }
 
     auto CPU = "generic";
     auto Features = "";
 
+    const CodeGenOpt::Level CodeGenLevels[] = { CodeGenOpt::None, CodeGenOpt::Less, CodeGenOpt::Default, CodeGenOpt::Aggressive };
+    const OptimizationLevel OptLevels[] = { OptimizationLevel::O0, OptimizationLevel::O1, OptimizationLevel::O2, OptimizationLevel::O3 };
+    int level = std::clamp(options.OptLevel, 0, 3);
+
     TargetOptions opt;
-    auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, Reloc::PIC_);
+    auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, Reloc::PIC_, None, CodeGenLevels[level]);
+
+    Context = std::make_unique<LLVMContext>();
+    TheModule = std::make_unique<Module>(options.Input, *Context);
+    Builder = std::make_unique<IRBuilder<>>(*Context);
+    NamedValues.clear();
+    GlobalValues.clear();
+    m_Structs.clear();
+    m_Aggregates.clear();
+    m_LoopIndices.clear();
 
     TheModule->setDataLayout(TargetMachine->createDataLayout());
     TheModule->setTargetTriple(TargetTriple);
 
-    return errors;
-  }
-
-  // Value *VarDefExprAST::Generate() {
-  //   AllocaInst *OldBinding;
-  //   GlobalVariable *OldGBinding;
-
-  //   Value *InitVal 
-  //     = m_Expr == nullptr ? ConstantFP::get(*Context, APFloat(0.0))
-  //       : m_Expr->Generate();
-  //   if (!InitVal) throw std::runtime_error("Failed!");
-
-  //   bool isLocal;
-  //   std::optional<AllocaInst *> Alloca;
-  //   std::optional<GlobalVariable *> GlobalVar;
-  //   if ((isLocal = Builder->GetInsertBlock())) {
-  //     Function *TheFunction = Builder->GetInsertBlock()->getParent();
-  //     Alloca = CreateEntryBlockAlloca(TheFunction, m_Name);
-  //     Builder->CreateStore(InitVal, Alloca.value());
-  //   }
-  //   else {
-  //     GlobalVar = CreateGlobal();
-  //   }
-
-  //   if (!(Alloca.has_value() || GlobalVar.has_value())) throw std::runtime_error("Failed to VarDef!");
-
-  //   if (isLocal) {
-  //     OldBinding = NamedValues[m_Name];
-  //     NamedValues[m_Name] = Alloca.value();
-  //     // NamedValues[m_Name] = OldBinding; - once we implement scopes = pop variables
-  //   } 
-  //   else {
-  //     OldGBinding = GlobalValues[m_Name];
-  //     GlobalValues[m_Name] = GlobalVar.value();
-  //     // GlobalValues[m_Name] = OldGBinding; - once we implement scopes = pop variables
-  //   }
-
-  //   return (isLocal ? (Value*)NamedValues[m_Name] : (Value*)GlobalValues[m_Name]);
-  // }
-
-  // GlobalVariable *VarDefExprAST::CreateGlobal() {
-  //   GlobalVariable* gVar = (GlobalVariable*)TheModule->getOrInsertGlobal(m_Name.c_str(), Builder->getDoubleTy());
-  //   gVar->setLinkage(GlobalValue::PrivateLinkage);
-  //   gVar->setAlignment(Align(alignof(double)));
-
-  //   Value *InitVal = !m_Expr ? ConstantFP::get(*Context, APFloat(0.0)) : m_Expr->Generate();
-  //   gVar->setInitializer(cast<Constant>(InitVal));
-
-  //   return gVar;
-  // }
-
-  // Value *VariableExprAST::Generate() {
-  //   if (GlobalValues.find(m_Name) != GlobalValues.end()) {
-  //     auto var = GlobalValues[m_Name];
-  //     if (!var) {
-  //         throw std::runtime_error("Global variable pointer is null: \"" + m_Name + "\"");
-  //     }
-  //     return Builder->CreateLoad(var->getValueType(), var, m_Name.c_str());
-  //   } else {
-  //     if (NamedValues.find(m_Name) == NamedValues.end()) {
-  //       throw std::runtime_error("Unknown variable name: \"" + m_Name + "\"");
-  //     }
-  //     AllocaInst *A = NamedValues[m_Name];
-  //     if (!A) {
-  //       throw std::runtime_error("Local variable pointer is null: \"" + m_Name + "\"");
-  //     }
-  //     return Builder->CreateLoad(A->getAllocatedType(), A, m_Name.c_str());
-  //   }
-  // }
-
-  // Value *BinOpExprAST::Generate() {
-  //   Value *L = m_LHS->Generate();
-  //   Value *R = m_RHS->Generate();
-  //   if (!L || !R)
-  //     return nullptr;
-
-  //   switch (m_OpCode) {
-  //   case Token::Type::TOKN_PLUS:
-  //     return Builder->CreateFAdd(L, R, "addtmp");
-  //   case Token::Type::TOKN_MINUS:
-  //     return Builder->CreateFSub(L, R, "subtmp");
-  //   case Token::Type::TOKN_STAR:
-  //     return Builder->CreateFMul(L, R, "multmp");
-  //   case Token::Type::TOKN_FSLASH:
-  //     return Builder->CreateFDiv(L, R, "divtmp");
-  //   default: throw std::runtime_error("Invalid binary operator " + Token::ToString(m_OpCode) + "!");
-  //   }
-  // }
-
-  // Value *ProgramAST::Generate() {
-  //   Value *val = nullptr;
-  //   for (auto &stmt : m_Stmts) val = stmt->Generate();
-  //   TheModule->print(errs(), nullptr);
-  //   return val;
-  // }
+    // Top-level statements are executed by main
+    FunctionType *MainTy = FunctionType::get(Builder->getInt32Ty(), false);
+    m_Main = Function::Create(MainTy, Function::ExternalLinkage, "main", TheModule.get());
+    Builder->SetInsertPoint(BasicBlock::Create(*Context, "entry", m_Main));
+
+    for (auto &stmt : m_Program->GetStatements()) GenerateStmt(stmt.get());
+    Builder->CreateRet(Builder->getInt32(0));
+
+    std::string VerifyMsg;
+    raw_string_ostream VerifyStream(VerifyMsg);
+    if (verifyModule(*TheModule, &VerifyStream)) error("Invalid module: " + VerifyStream.str());
+    if (!m_Errors.empty()) return m_Errors;
+
+    if (level > 0) {
+      LoopAnalysisManager LAM;
+      FunctionAnalysisManager FAM;
+      CGSCCAnalysisManager CGAM;
+      ModuleAnalysisManager MAM;
+
+      PassBuilder PB(TargetMachine);
+      PB.registerModuleAnalyses(MAM);
+      PB.registerCGSCCAnalyses(CGAM);
+      PB.registerFunctionAnalyses(FAM);
+      PB.registerLoopAnalyses(LAM);
+      PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+      ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(OptLevels[level]);
+      MPM.run(*TheModule, MAM);
+    }
+
+    auto Output = options.Output;
+    if (Output.empty()) Output = std::filesystem::path(options.Input).replace_extension(".o").string();
+
+    std::error_code EC;
+    raw_fd_ostream dest(Output, EC, sys::fs::OF_None);
+    if (EC) {
+      error("Could not open file \"" + Output + "\": " + EC.message());
+      return m_Errors;
+    }
+
+    legacy::PassManager pass;
+    if (TargetMachine->addPassesToEmitFile(pass, dest, nullptr, CGFT_ObjectFile)) {
+      error("Target can't emit a file of this type!");
+      return m_Errors;
+    }
+    pass.run(*TheModule);
+    dest.flush();
+
+    return m_Errors;
+  }
+
+  // private:
+
+  void Generator::GenerateStmt(StmtNode *stmt) {
+    if (auto decl = dynamic_cast<VarDeclStmt*>(stmt)) GenerateVarDecl(decl);
+    else if (auto scope = dynamic_cast<ScopeStmt*>(stmt)) GenerateScope(scope);
+    else if (auto join = dynamic_cast<JoinStmt*>(stmt)) GenerateJoin(join);
+    else if (auto loop = dynamic_cast<ForStmt*>(stmt)) GenerateFor(loop);
+    else if (auto decl = dynamic_cast<StructDeclStmt*>(stmt)) GenerateStructDecl(decl);
+    else if (auto decl = dynamic_cast<ArrayDeclStmt*>(stmt)) GenerateArrayDecl(decl);
+    else if (auto expr = dynamic_cast<ExprNode*>(stmt)) GenerateExpr(expr);
+    else error("Unsupported statement!");
+  }
+
+  // Number literals can be longer than a double can hold, false instead of throwing like std::stod
+  static bool ParseNumber(const std::string &text, double &value) {
+    char *end = nullptr;
+    errno = 0;
+    value = std::strtod(text.c_str(), &end);
+    return errno != ERANGE && end == text.c_str() + text.size() && !text.empty();
+  }
+
+  Value *Generator::GenerateExpr(ExprNode *expr) {
+    if (!expr) return error("Expected expression!");
+
+    if (auto ident = dynamic_cast<IdentExpr*>(expr)) return GenerateIdent(ident);
+    if (auto num = dynamic_cast<NumLitExpr*>(expr)) {
+      auto &text = num->GetValue().value.value();
+      double value = 0.0;
+      if (!ParseNumber(text, value)) return error("Invalid or out of range number \"" + text + "\"!");
+      return ConstantFP::get(*Context, APFloat(value));
+    }
+    if (auto str = dynamic_cast<StrLitExpr*>(expr)) {
+      // Strings are passed around as pointers, which ULang stores as numbers
+      auto ptr = Builder->CreateGlobalStringPtr(str->GetValue().value.value_or(""));
+      return Builder->CreateSIToFP(Builder->CreatePtrToInt(ptr, Builder->getInt64Ty()), Builder->getDoubleTy());
+    }
+    if (auto bin = dynamic_cast<BinExpr*>(expr)) return GenerateBinExpr(bin);
+    if (auto assign = dynamic_cast<AssignmentExpr*>(expr)) return GenerateAssignment(assign);
+    if (auto call = dynamic_cast<CallExpr*>(expr)) return GenerateCall(call);
+    if (auto spawn = dynamic_cast<SpawnExpr*>(expr)) return GenerateSpawn(spawn);
+    if (dynamic_cast<IndexExpr*>(expr) || dynamic_cast<MemberExpr*>(expr)) {
+      Value *Ptr = GenerateAddress(expr);
+      if (!Ptr) return nullptr;
+      return Builder->CreateLoad(Builder->getDoubleTy(), Ptr);
+    }
+
+    return error("Unsupported expression!");
+  }
+
+  Value *Generator::GenerateVarDecl(VarDeclStmt *stmt) {
+    auto name = stmt->GetIdent().value.value();
+    auto &types = stmt->GetTypes();
+    if (!types.empty() && m_Structs.find(types.back()) != m_Structs.end()) {
+      if (stmt->GetValue()) return error("Struct variable \"" + name + "\" can't be initialized!");
+      if (m_ScopeDepth != 0 || Builder->GetInsertBlock()->getParent() != m_Main)
+        return error("Struct variable \"" + name + "\" has to be declared in the global scope!");
+      declareAggregate(name, types, 1, false);
+      return nullptr;
+    }
+
+    Value *InitVal = stmt->GetValue() ? GenerateExpr(stmt->GetValue())
+                                      : ConstantFP::get(*Context, APFloat(0.0));
+    if (!InitVal) return nullptr;
+
+    // Declarations in main's outermost scope are globals, so every function can see them
+    bool isGlobal = m_ScopeDepth == 0 && Builder->GetInsertBlock()->getParent() == m_Main;
+    if (isGlobal) {
+      if (GlobalValues.find(name) != GlobalValues.end() || m_Aggregates.find(name) != m_Aggregates.end())
+        return error("Redefinition of variable \"" + name + "\"!");
+      auto gVar = (GlobalVariable*)TheModule->getOrInsertGlobal(name, Builder->getDoubleTy());
+      gVar->setLinkage(GlobalValue::PrivateLinkage);
+      gVar->setAlignment(Align(alignof(double)));
+      gVar->setInitializer(ConstantFP::get(*Context, APFloat(0.0)));
+      Builder->CreateStore(InitVal, gVar);
+      GlobalValues[name] = gVar;
+      return gVar;
+    }
+
+    AllocaInst *Alloca = CreateEntryBlockAlloca(Builder->GetInsertBlock()->getParent(), name);
+    Builder->CreateStore(InitVal, Alloca);
+    NamedValues[name] = Alloca;
+    m_LoopIndices.erase(name); // Shadows a loop variable until the scope ends
+    return Alloca;
+  }
+
+  Value *Generator::GenerateIdent(IdentExpr *expr) {
+    auto &name = expr->GetSymbol();
+    if (NamedValues.find(name) != NamedValues.end()) {
+      AllocaInst *A = NamedValues[name];
+      return Builder->CreateLoad(A->getAllocatedType(), A, name);
+    }
+    if (GlobalValues.find(name) != GlobalValues.end()) {
+      GlobalVariable *G = GlobalValues[name];
+      return Builder->CreateLoad(G->getValueType(), G, name);
+    }
+    if (m_Aggregates.find(name) != m_Aggregates.end())
+      return error("\"" + name + "\" is an array or struct, use one of its elements!");
+    return error("Unknown variable name: \"" + name + "\"");
+  }
+
+  Value *Generator::GenerateBinExpr(BinExpr *expr) {
+    Value *L = GenerateExpr(expr->GetLeft());
+    Value *R = GenerateExpr(expr->GetRight());
+    if (!L || !R) return nullptr;
+
+    switch (expr->GetOp()) {
+    case Token::Type::TOKN_PLUS:   return Builder->CreateFAdd(L, R, "addtmp");
+    case Token::Type::TOKN_MINUS:  return Builder->CreateFSub(L, R, "subtmp");
+    case Token::Type::TOKN_STAR:   return Builder->CreateFMul(L, R, "multmp");
+    case Token::Type::TOKN_FSLASH: return Builder->CreateFDiv(L, R, "divtmp");
+    default: return error("Invalid binary operator " + Token::ToString(expr->GetOp()) + "!");
+    }
+  }
+
+  Value *Generator::GenerateAssignment(AssignmentExpr *expr) {
+    auto assigne = expr->GetAssigne();
+    if (!dynamic_cast<IdentExpr*>(assigne) && !dynamic_cast<IndexExpr*>(assigne) && !dynamic_cast<MemberExpr*>(assigne))
+      return error("Left side of an assignment must be a variable, array element or field!");
+    if (auto ident = dynamic_cast<IdentExpr*>(assigne); ident && m_LoopIndices.find(ident->GetSymbol()) != m_LoopIndices.end())
+      return error("Loop variable \"" + ident->GetSymbol() + "\" can't be assigned!");
+
+    Value *Val = GenerateExpr(expr->GetValue());
+    if (!Val) return nullptr;
+    Value *Ptr = GenerateAddress(assigne);
+    if (!Ptr) return nullptr;
+
+    Builder->CreateStore(Val, Ptr);
+    return Val;
+  }
+
+  static llvm::Type *BuiltinType(Builtin::Type type) {
+    switch (type) {
+    case Builtin::Type::Void:   return Builder->getVoidTy();
+    case Builtin::Type::Int:    return Builder->getInt64Ty();
+    case Builtin::Type::Double: return Builder->getDoubleTy();
+    case Builtin::Type::Ptr:    return Builder->getInt8PtrTy();
+    }
+    return nullptr;
+  }
+
+  Value *Generator::GenerateCall(CallExpr *expr) {
+    auto &name = expr->GetCallee();
+    if (Builtins.find(name) == Builtins.end()) return error("Unknown function \"" + name + "\"!");
+    auto &builtin = Builtins[name];
+
+    auto &args = expr->GetArgs();
+    if (args.size() != builtin.Params.size())
+      return error("Function \"" + name + "\" expects " + std::to_string(builtin.Params.size()) +
+                   " argument(s), but got " + std::to_string(args.size()) + "!");
+
+    std::vector<llvm::Type*> ParamTys{};
+    for (auto param : builtin.Params) ParamTys.push_back(BuiltinType(param));
+    FunctionType *FT = FunctionType::get(BuiltinType(builtin.Ret), ParamTys, false);
+    FunctionCallee Callee = TheModule->getOrInsertFunction(builtin.Symbol, FT);
+
+    std::vector<Value*> ArgVals{};
+    for (size_t i = 0; i < args.size(); ++i) {
+      Value *Arg = GenerateExpr(args[i].get());
+      if (!Arg) return nullptr;
+      switch (builtin.Params[i]) {
+      case Builtin::Type::Int: Arg = Builder->CreateFPToSI(Arg, Builder->getInt64Ty()); break;
+      case Builtin::Type::Ptr:
+        Arg = Builder->CreateIntToPtr(Builder->CreateFPToSI(Arg, Builder->getInt64Ty()), Builder->getInt8PtrTy());
+        break;
+      default: break;
+      }
+      ArgVals.push_back(Arg);
+    }
+
+    Value *Res = Builder->CreateCall(Callee, ArgVals);
+    switch (builtin.Ret) {
+    case Builtin::Type::Void: return ConstantFP::get(*Context, APFloat(0.0));
+    case Builtin::Type::Int:  return Builder->CreateSIToFP(Res, Builder->getDoubleTy());
+    case Builtin::Type::Ptr:
+      return Builder->CreateSIToFP(Builder->CreatePtrToInt(Res, Builder->getInt64Ty()), Builder->getDoubleTy());
+    default: return Res;
+    }
+  }
+
+  void Generator::GenerateScope(ScopeStmt *stmt) {
+    auto OldNamedValues = NamedValues;
+    auto OldLoopIndices = m_LoopIndices;
+    m_ScopeDepth++;
+    for (auto &inner : stmt->GetStatements()) GenerateStmt(inner.get());
+    m_ScopeDepth--;
+    NamedValues = OldNamedValues;
+    m_LoopIndices = OldLoopIndices;
+  }
+
+  Value *Generator::GenerateSpawn(SpawnExpr *expr) {
+    // Outline the body into `void (i8*)`, it can only see globals
+    auto I8Ptr = Builder->getInt8PtrTy();
+    FunctionType *BodyTy = FunctionType::get(Builder->getVoidTy(), { I8Ptr }, false);
+    Function *Body = Function::Create(BodyTy, Function::PrivateLinkage, "ulang.spawn", TheModule.get());
+
+    auto OldIP = Builder->saveIP();
+    auto OldNamedValues = NamedValues;
+    auto OldLoopIndices = m_LoopIndices;
+    NamedValues.clear();
+    m_LoopIndices.clear();
+    Builder->SetInsertPoint(BasicBlock::Create(*Context, "entry", Body));
+    GenerateScope(expr->GetBody());
+    Builder->CreateRetVoid();
+    NamedValues = OldNamedValues;
+    m_LoopIndices = OldLoopIndices;
+    Builder->restoreIP(OldIP);
+
+    FunctionCallee Spawn = TheModule->getOrInsertFunction("ulang_spawn",
+      FunctionType::get(I8Ptr, { BodyTy->getPointerTo(), I8Ptr }, false));
+    Value *Handle = Builder->CreateCall(Spawn, { Body, ConstantPointerNull::get(I8Ptr) }, "handle");
+    return Builder->CreateSIToFP(Builder->CreatePtrToInt(Handle, Builder->getInt64Ty()), Builder->getDoubleTy());
+  }
+
+  void Generator::GenerateJoin(JoinStmt *stmt) {
+    Value *Handle = GenerateExpr(stmt->GetHandle());
+    if (!Handle) return;
+
+    auto I8Ptr = Builder->getInt8PtrTy();
+    FunctionCallee Join = TheModule->getOrInsertFunction("ulang_join",
+      FunctionType::get(Builder->getVoidTy(), { I8Ptr }, false));
+    Builder->CreateCall(Join, { Builder->CreateIntToPtr(Builder->CreateFPToSI(Handle, Builder->getInt64Ty()), I8Ptr) });
+  }
+
+  void Generator::GenerateFor(ForStmt *stmt) {
+    Value *Begin = GenerateIndex(stmt->GetBegin());
+    Value *End = GenerateIndex(stmt->GetEnd());
+    if (!Begin || !End) return;
+
+    if (!stmt->IsParallel()) {
+      auto OldNamedValues = NamedValues;
+      auto OldLoopIndices = m_LoopIndices;
+      GenerateLoop(stmt->GetIdent().value.value(), Begin, End, stmt->GetBody());
+      NamedValues = OldNamedValues;
+      m_LoopIndices = OldLoopIndices;
+      return;
+    }
+
+    // Outline the body into `void (i64 begin, i64 end, i8*)` looping over its chunk,
+    // so the loop itself stays visible to the optimizer
+    auto I64 = Builder->getInt64Ty();
+    auto I8Ptr = Builder->getInt8PtrTy();
+    FunctionType *BodyTy = FunctionType::get(Builder->getVoidTy(), { I64, I64, I8Ptr }, false);
+    Function *Body = Function::Create(BodyTy, Function::PrivateLinkage, "ulang.parallel_for", TheModule.get());
+
+    auto OldIP = Builder->saveIP();
+    auto OldNamedValues = NamedValues;
+    auto OldLoopIndices = m_LoopIndices;
+    NamedValues.clear();
+    m_LoopIndices.clear();
+
+    auto ChunkBegin = Body->getArg(0), ChunkEnd = Body->getArg(1);
+    ChunkBegin->setName("begin");
+    ChunkEnd->setName("end");
+
+    Builder->SetInsertPoint(BasicBlock::Create(*Context, "entry", Body));
+    GenerateLoop(stmt->GetIdent().value.value(), ChunkBegin, ChunkEnd, stmt->GetBody());
+    Builder->CreateRetVoid();
+
+    NamedValues = OldNamedValues;
+    m_LoopIndices = OldLoopIndices;
+    Builder->restoreIP(OldIP);
+
+    FunctionCallee ParallelFor = TheModule->getOrInsertFunction("ulang_parallel_for",
+      FunctionType::get(Builder->getVoidTy(), { I64, I64, BodyTy->getPointerTo(), I8Ptr }, false));
+    Builder->CreateCall(ParallelFor, { Begin, End, Body, ConstantPointerNull::get(I8Ptr) });
+  }
+
+  void Generator::GenerateLoop(const std::string &name, Value *Begin, Value *End, ScopeStmt *body) {
+    Function *TheFunction = Builder->GetInsertBlock()->getParent();
+    BasicBlock *PreheaderBB = Builder->GetInsertBlock();
+    BasicBlock *CondBB = BasicBlock::Create(*Context, "cond", TheFunction);
+    BasicBlock *LoopBB = BasicBlock::Create(*Context, "loop", TheFunction);
+    BasicBlock *ExitBB = BasicBlock::Create(*Context, "exit", TheFunction);
+
+    AllocaInst *IndexVar = CreateEntryBlockAlloca(TheFunction, name);
+    Builder->CreateBr(CondBB);
+
+    Builder->SetInsertPoint(CondBB);
+    PHINode *Index = Builder->CreatePHI(Builder->getInt64Ty(), 2, "index");
+    Index->addIncoming(Begin, PreheaderBB);
+    Builder->CreateCondBr(Builder->CreateICmpSLT(Index, End), LoopBB, ExitBB);
+
+    Builder->SetInsertPoint(LoopBB);
+    Builder->CreateStore(Builder->CreateSIToFP(Index, Builder->getDoubleTy()), IndexVar);
+    NamedValues[name] = IndexVar;
+    m_LoopIndices[name] = Index;
+    GenerateScope(body);
+    Value *Next = Builder->CreateNSWAdd(Index, Builder->getInt64(1), "next");
+    Index->addIncoming(Next, Builder->GetInsertBlock());
+    Builder->CreateBr(CondBB);
+
+    Builder->SetInsertPoint(ExitBB);
+  }
+
+  void Generator::GenerateStructDecl(StructDeclStmt *stmt) {
+    auto name = stmt->GetIdent().value.value();
+    if (m_Structs.find(name) != m_Structs.end()) {
+      error("Redefinition of struct \"" + name + "\"!");
+      return;
+    }
+
+    StructInfo info{};
+    info.SoA = stmt->IsSoA();
+    std::vector<llvm::Type*> FieldTys{};
+    for (auto &field : stmt->GetFields()) {
+      auto fieldName = field.Ident.value.value();
+      if (m_Structs.find(field.Types.back()) != m_Structs.end()) {
+        error("Field \"" + fieldName + "\" of \"" + name + "\": struct fields can't be structs yet!");
+        return;
+      }
+      if (std::find(info.Fields.begin(), info.Fields.end(), fieldName) != info.Fields.end()) {
+        error("Duplicate field \"" + fieldName + "\" in struct \"" + name + "\"!");
+        return;
+      }
+      info.Fields.push_back(fieldName);
+      FieldTys.push_back(Builder->getDoubleTy());
+    }
+    info.Type = StructType::create(*Context, FieldTys, name);
+    m_Structs[name] = info;
+  }
+
+  void Generator::GenerateArrayDecl(ArrayDeclStmt *stmt) {
+    auto name = stmt->GetIdent().value.value();
+    if (m_ScopeDepth != 0 || Builder->GetInsertBlock()->getParent() != m_Main) {
+      error("Array \"" + name + "\" has to be declared in the global scope!");
+      return;
+    }
+
+    auto size = dynamic_cast<NumLitExpr*>(stmt->GetSize());
+    double count = 0.0;
+    if (!size || !ParseNumber(size->GetValue().value.value(), count) || count < 1.0 ||
+        count >= 18446744073709551616.0 || count != (double)(uint64_t)count) {
+      error("Size of array \"" + name + "\" has to be a positive whole number!");
+      return;
+    }
+
+    declareAggregate(name, stmt->GetTypes(), (uint64_t)count, true);
+  }
+
+  Value *Generator::GenerateAddress(ExprNode *expr) {
+    if (auto ident = dynamic_cast<IdentExpr*>(expr)) {
+      auto &name = ident->GetSymbol();
+      if (NamedValues.find(name) != NamedValues.end()) return NamedValues[name];
+      if (GlobalValues.find(name) != GlobalValues.end()) return GlobalValues[name];
+      if (m_Aggregates.find(name) != m_Aggregates.end())
+        return error("\"" + name + "\" is an array or struct, use one of its elements!");
+      return error("Unknown variable name: \"" + name + "\"");
+    }
+
+    // Either array[index], array[index].field or object.field
+    const Token *field = nullptr;
+    Value *Idx = nullptr;
+    ExprNode *base = expr;
+    if (auto member = dynamic_cast<MemberExpr*>(base)) {
+      field = &member->GetField();
+      base = member->GetBase();
+    }
+    if (auto index = dynamic_cast<IndexExpr*>(base)) {
+      if (!(Idx = GenerateIndex(index->GetIndex()))) return nullptr;
+      base = index->GetBase();
+    }
+
+    auto ident = dynamic_cast<IdentExpr*>(base);
+    if (!ident) return error("Only arrays and struct variables can be indexed or have fields!");
+    auto &name = ident->GetSymbol();
+    if (m_Aggregates.find(name) == m_Aggregates.end()) return error("Unknown array or struct variable \"" + name + "\"");
+    auto &agg = m_Aggregates[name];
+
+    if (!Idx) {
+      if (agg.IsArray) return error("Array \"" + name + "\" has to be indexed!");
+      Idx = Builder->getInt64(0);
+    }
+    else if (!agg.IsArray) return error("\"" + name + "\" is not an array!");
+
+    if (!field) {
+      if (agg.Struct) return error("Elements of \"" + name + "\" have to be accessed through a field!");
+      return Builder->CreateInBoundsGEP(agg.Data->getValueType(), agg.Data, { Builder->getInt64(0), Idx });
+    }
+    if (!agg.Struct) return error("\"" + name + "\" has no fields!");
+
+    auto fieldName = field->value.value();
+    auto &fields = agg.Struct->Fields;
+    auto it = std::find(fields.begin(), fields.end(), fieldName);
+    if (it == fields.end())
+      return error("Struct \"" + agg.Struct->Type->getName().str() + "\" has no field \"" + fieldName + "\"!");
+    unsigned fieldIdx = (unsigned)(it - fields.begin());
+
+    // The layout only changes the address, sources look the same for both
+    if (agg.Struct->SoA) {
+      GlobalVariable *Column = agg.Fields[fieldIdx];
+      return Builder->CreateInBoundsGEP(Column->getValueType(), Column, { Builder->getInt64(0), Idx }, name + "." + fieldName);
+    }
+    return Builder->CreateInBoundsGEP(agg.Data->getValueType(), agg.Data,
+                                      { Builder->getInt64(0), Idx, Builder->getInt32(fieldIdx) }, name + "." + fieldName);
+  }
+
+  // Whole number literal that fits into an i64
+  static bool ParseInteger(const std::string &text, int64_t &value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+  }
+
+  // Whole numbers and loop variables combined with + - *
+  static bool IsIntegral(ExprNode *expr, const std::map<std::string, PHINode*> &loopIndices) {
+    int64_t value = 0;
+    if (auto ident = dynamic_cast<IdentExpr*>(expr)) return loopIndices.find(ident->GetSymbol()) != loopIndices.end();
+    if (auto num = dynamic_cast<NumLitExpr*>(expr)) return ParseInteger(num->GetValue().value.value(), value);
+    if (auto bin = dynamic_cast<BinExpr*>(expr)) {
+      auto op = bin->GetOp();
+      return (op == Token::Type::TOKN_PLUS || op == Token::Type::TOKN_MINUS || op == Token::Type::TOKN_STAR) &&
+             IsIntegral(bin->GetLeft(), loopIndices) && IsIntegral(bin->GetRight(), loopIndices);
+    }
+    return false;
+  }
+
+  Value *Generator::GenerateIndex(ExprNode *expr) {
+    if (!IsIntegral(expr, m_LoopIndices)) {
+      Value *Val = GenerateExpr(expr);
+      return Val ? Builder->CreateFPToSI(Val, Builder->getInt64Ty()) : nullptr;
+    }
+
+    if (auto ident = dynamic_cast<IdentExpr*>(expr)) return m_LoopIndices[ident->GetSymbol()];
+    if (auto num = dynamic_cast<NumLitExpr*>(expr)) {
+      int64_t value = 0;
+      ParseInteger(num->GetValue().value.value(), value); // Checked by IsIntegral
+      return Builder->getInt64(value);
+    }
+    auto bin = (BinExpr*)expr;
+    Value *L = GenerateIndex(bin->GetLeft());
+    Value *R = GenerateIndex(bin->GetRight());
+    switch (bin->GetOp()) {
+    case Token::Type::TOKN_PLUS:  return Builder->CreateNSWAdd(L, R);
+    case Token::Type::TOKN_MINUS: return Builder->CreateNSWSub(L, R);
+    default:                      return Builder->CreateNSWMul(L, R);
+    }
+  }
+
+  Generator::AggregateInfo *Generator::declareAggregate(const std::string &name, const std::vector<std::string> &types, uint64_t count, bool isArray) {
+    if (GlobalValues.find(name) != GlobalValues.end() || m_Aggregates.find(name) != m_Aggregates.end()) {
+      error("Redefinition of variable \"" + name + "\"!");
+      return nullptr;
+    }
+
+    AggregateInfo info{};
+    info.IsArray = isArray;
+    info.Count = count;
+    if (!types.empty() && m_Structs.find(types.back()) != m_Structs.end()) info.Struct = &m_Structs[types.back()];
+
+    // Cache line aligned, so vectorized loops start on an aligned element
+    auto makeGlobal = [&](llvm::Type *Ty, const std::string &globalName) {
+      auto G = new GlobalVariable(*TheModule, Ty, false, GlobalValue::PrivateLinkage, ConstantAggregateZero::get(Ty), globalName);
+      G->setAlignment(Align(64));
+      return G;
+    };
+
+    if (info.Struct && info.Struct->SoA) {
+      for (auto &field : info.Struct->Fields)
+        info.Fields.push_back(makeGlobal(ArrayType::get(Builder->getDoubleTy(), count), name + "." + field));
+    } else {
+      llvm::Type *ElemTy = info.Struct ? (llvm::Type*)info.Struct->Type : Builder->getDoubleTy();
+      info.Data = makeGlobal(ArrayType::get(ElemTy, count), name);
+    }
+
+    return &(m_Aggregates[name] = info);
+  }
+
+  Value *Generator::error(const std::string &description) {
+    m_Errors.push_back({ description });
+    return nullptr;
+  }
 
   Compiler::Compiler(const CompilerOptions &options)
     : m_Options(options) {
@@ -193,7 +649,24 @@ namespace UraniumLang {
   bool Compiler::Compile() {
     auto progNode = m_Parser->Parse();
 
-    return true;
+    // Report every problem in the source at once, there is nothing worth generating if any were found
+    m_Errors.clear();
+    for (auto &diag : m_Parser->GetDiagnostics()) m_Errors.push_back({ diag.Message, diag.Line, diag.Column });
+    if (!m_Errors.empty()) {
+      std::stable_sort(m_Errors.begin(), m_Errors.end(), [](const CompilationError &a, const CompilationError &b) {
+        return a.Line != b.Line ? a.Line < b.Line : a.Column < b.Column;
+      });
+      return false;
+    }
+
+    if (!m_Options.ASTOutput.empty() && !WriteAST(progNode.get(), m_Options.ASTOutput)) {
+      m_Errors.push_back({ "Failed to write binary AST to \"" + m_Options.ASTOutput + "\"!" });
+      return false;
+    }
+
+    Generator generator(std::move(progNode));
+    m_Errors = generator.Generate(m_Options);
+    return m_Errors.empty();
   }
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define ULANG_COMPILER_H_
 
 #include <parser.h> // Include ULang's Parser
+#include <astfile.h>
 
 #include <stdio.h>
 
@@ -19,7 +20,9 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -30,7 +33,7 @@ static UraniumLang::uptr<LLVMContext> Context{};
 static UraniumLang::uptr<Module> TheModule{};
 static std::map<std::string, AllocaInst*> NamedValues{};      // { name, value }
 static std::map<std::string, GlobalVariable*> GlobalValues{}; // { name, value }
-static std::unique_ptr<IRBuilder<>> Builder = std::make_unique<IRBuilder<>>(*Context);
+static std::unique_ptr<IRBuilder<>> Builder{};
 
 static AllocaInst *CreateEntryBlockAlloca(Function *TheFunction,
                                           StringRef VarName) {
@@ -48,26 +51,111 @@ namespace UraniumLang {
     std::string Input{}, Output{};
     std::vector<std::string> IncludeDirs{};
     bool ULangBitcode = false;
+    int OptLevel = 0; // -O0 .. -O3
+    std::string ASTOutput{}; // Binary AST is written here too if set
   };
 
   CompilerOptions ParseArguments(int argc, char **argv);
 
   struct CompilationError {
     std::string Description{};
+    int Line = 0, Column = 0; // 0 = no position (e.g. code generation errors)
 
     friend std::ostream &operator <<(std::ostream &os, const CompilationError &err) {
+      if (err.Line > 0) os << err.Line << ":" << err.Column << ": ";
       return os << err.Description;
     }
   };
 
+  // Runtime functions callable from ULang (implemented in runtime/)
+  //  ULang only has doubles, arguments and results are converted at the call
+  struct Builtin {
+    enum class Type { Void, Int, Double, Ptr };
+
+    std::string Symbol{};
+    Type Ret = Type::Void;
+    std::vector<Type> Params{};
+  };
+
+  inline static std::map<std::string, Builtin> Builtins = { // ULang name | runtime function
+    { "alloc",              { "ulang_alloc",              Builtin::Type::Ptr,  { Builtin::Type::Int } } },
+    { "free",               { "ulang_free",               Builtin::Type::Void, { Builtin::Type::Ptr } } },
+    { "frame_alloc",        { "ulang_frame_alloc",        Builtin::Type::Ptr,  { Builtin::Type::Int } } },
+    { "frame_reset",        { "ulang_frame_reset",        Builtin::Type::Void, {} } },
+    { "pool_create",        { "ulang_pool_create",        Builtin::Type::Ptr,  { Builtin::Type::Int } } },
+    { "pool_alloc",         { "ulang_pool_alloc",         Builtin::Type::Ptr,  { Builtin::Type::Ptr } } },
+    { "pool_free",          { "ulang_pool_free",          Builtin::Type::Void, { Builtin::Type::Ptr, Builtin::Type::Ptr } } },
+    { "pool_destroy",       { "ulang_pool_destroy",       Builtin::Type::Void, { Builtin::Type::Ptr } } },
+    { "alloc_bytes_in_use", { "ulang_alloc_bytes_in_use", Builtin::Type::Int,  {} } },
+    { "alloc_peak_bytes",   { "ulang_alloc_peak_bytes",   Builtin::Type::Int,  {} } },
+    { "jobs_init",          { "ulang_jobs_init",          Builtin::Type::Void, { Builtin::Type::Int } } },
+    { "print",              { "ulang_print_num",          Builtin::Type::Void, { Builtin::Type::Double } } },
+    { "sqrt",               { "sqrt",                     Builtin::Type::Double, { Builtin::Type::Double } } },
+    { "str_new",            { "ulang_str_new",            Builtin::Type::Ptr,  {} } },
+    { "str_append",         { "ulang_str_append",         Builtin::Type::Void, { Builtin::Type::Ptr, Builtin::Type::Ptr } } },
+    { "str_append_num",     { "ulang_str_append_num",     Builtin::Type::Void, { Builtin::Type::Ptr, Builtin::Type::Double } } },
+    { "str_length",         { "ulang_str_length",         Builtin::Type::Int,  { Builtin::Type::Ptr } } },
+    { "str_print",          { "ulang_str_print",          Builtin::Type::Void, { Builtin::Type::Ptr } } },
+    { "str_free",           { "ulang_str_free",           Builtin::Type::Void, { Builtin::Type::Ptr } } },
+  };
+
   class Generator {
   public:
     Generator(uptr<ProgNode> program) : m_Program(std::move(program)) {}
     ~Generator() = default;
 
     std::vector<CompilationError> Generate(CompilerOptions options);
+  private:
+    void GenerateStmt(StmtNode *stmt);
+    Value *GenerateExpr(ExprNode *expr);
+    Value *GenerateVarDecl(VarDeclStmt *stmt);
+    Value *GenerateIdent(IdentExpr *expr);
+    Value *GenerateBinExpr(BinExpr *expr);
+    Value *GenerateAssignment(AssignmentExpr *expr);
+    Value *GenerateCall(CallExpr *expr);
+    void GenerateScope(ScopeStmt *stmt);
+    // spawn, join and parallel_for are lowered to calls into the runtime's job system (runtime/jobs.h)
+    Value *GenerateSpawn(SpawnExpr *expr);
+    void GenerateJoin(JoinStmt *stmt);
+    void GenerateFor(ForStmt *stmt);
+    // Counts name from Begin to End (i64) at the insert point, which ends up after the loop
+    void GenerateLoop(const std::string &name, Value *Begin, Value *End, ScopeStmt *body);
+    void GenerateStructDecl(StructDeclStmt *stmt);
+    void GenerateArrayDecl(ArrayDeclStmt *stmt);
+    // Pointer to the storage behind a variable, array element or field
+    Value *GenerateAddress(ExprNode *expr);
+    // Array indices as i64, loop variables are used without a round trip through double
+    Value *GenerateIndex(ExprNode *expr);
+
+    // Records a compilation error, always returns nullptr
+    Value *error(const std::string &description);
+  private:
+    struct StructInfo {
+      bool SoA = false;
+      std::vector<std::string> Fields{};
+      StructType *Type = nullptr;
+    };
+
+    // Arrays and struct variables (a struct variable is an array of one element)
+    //  AoS: Data is [Count x %Struct] (or [Count x double] for plain arrays)
+    //  SoA: Fields holds one [Count x double] per field
+    struct AggregateInfo {
+      StructInfo *Struct = nullptr;
+      bool IsArray = false;
+      uint64_t Count = 0;
+      GlobalVariable *Data = nullptr;
+      std::vector<GlobalVariable*> Fields{};
+    };
+
+    AggregateInfo *declareAggregate(const std::string &name, const std::vector<std::string> &types, uint64_t count, bool isArray);
   private:
     uptr<ProgNode> m_Program;
+    Function *m_Main = nullptr;
+    size_t m_ScopeDepth = 0;
+    std::map<std::string, StructInfo> m_Structs{};
+    std::map<std::string, AggregateInfo> m_Aggregates{};
+    std::map<std::string, PHINode*> m_LoopIndices{}; // Loop variables of the function being generated
+    std::vector<CompilationError> m_Errors{};
   };
 
   class Compiler {
@@ -0,0 +1,311 @@
+#include "astfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace UraniumLang {
+
+  static constexpr char Magic[4] = { 'U', 'A', 'S', 'T' };
+  static constexpr uint16_t ByteOrder = 0x0102;
+
+  static uint32_t checksum(const uint8_t *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+  }
+
+  // =============== [ Writer ] ===============
+  namespace {
+
+    bool toBinOp(Token::Type type, ASTBinOp &op) {
+      switch (type) {
+      case Token::Type::TOKN_PLUS:   op = ASTBinOp::Add; return true;
+      case Token::Type::TOKN_MINUS:  op = ASTBinOp::Sub; return true;
+      case Token::Type::TOKN_STAR:   op = ASTBinOp::Mul; return true;
+      case Token::Type::TOKN_FSLASH: op = ASTBinOp::Div; return true;
+      default:                       return false;
+      }
+    }
+
+    class Writer {
+    public:
+      Writer() { m_Nodes.resize(sizeof(ASTFileHeader)); }
+
+      std::vector<uint8_t> Finish(ProgNode *prog) {
+        uint32_t root = write(prog);
+
+        ASTFileHeader header{};
+        std::memcpy(header.Magic, Magic, sizeof(Magic));
+        header.Version = ASTVersion;
+        header.ByteOrder = ByteOrder;
+        header.Root = root;
+        header.NodesOffset = sizeof(ASTFileHeader);
+        header.NodesSize = m_Nodes.size() - sizeof(ASTFileHeader);
+        header.StringsOffset = m_Nodes.size();
+        header.StringCount = m_Strings.size();
+
+        // Strings go behind the nodes, characters padded so the file stays aligned
+        uint64_t chars = header.StringsOffset + m_Strings.size() * sizeof(ASTString);
+        std::vector<ASTString> table(m_Strings.size());
+        for (size_t i = 0; i < m_Strings.size(); ++i) {
+          table[i] = { (uint32_t)chars, (uint32_t)m_Strings[i]->size() };
+          chars += m_Strings[i]->size();
+        }
+        uint64_t size = (chars + 3) & ~3ull;
+        if (size > std::numeric_limits<uint32_t>::max()) return {};
+        header.Size = size;
+
+        std::vector<uint8_t> data = std::move(m_Nodes);
+        data.resize(size);
+        std::memcpy(&data[header.StringsOffset], table.data(), table.size() * sizeof(ASTString));
+        for (size_t i = 0; i < m_Strings.size(); ++i)
+          std::memcpy(&data[table[i].Offset], m_Strings[i]->data(), m_Strings[i]->size());
+
+        header.Checksum = checksum(data.data() + sizeof(ASTFileHeader), size - sizeof(ASTFileHeader));
+        std::memcpy(data.data(), &header, sizeof(header));
+        return data;
+      }
+    private:
+      // Writes node after its children, returns its offset (0 for nullptr)
+      uint32_t write(StmtNode *node) {
+        if (!node) return 0;
+
+        ASTNodeKind kind{};
+        uint16_t flags = 0;
+        std::vector<uint32_t> children{}, strings{};
+
+        if (auto prog = dynamic_cast<ProgNode*>(node)) {
+          kind = ASTNodeKind::Prog;
+          for (auto &stmt : prog->GetStatements()) children.push_back(write(stmt.get()));
+        }
+        else if (auto ident = dynamic_cast<IdentExpr*>(node)) {
+          kind = ASTNodeKind::Ident;
+          strings = { intern(ident->GetSymbol()) };
+        }
+        else if (auto num = dynamic_cast<NumLitExpr*>(node)) {
+          kind = ASTNodeKind::NumLit;
+          strings = { intern(num->GetValue().value.value_or("")) };
+        }
+        else if (auto str = dynamic_cast<StrLitExpr*>(node)) {
+          kind = ASTNodeKind::StrLit;
+          strings = { intern(str->GetValue().value.value_or("")) };
+        }
+        else if (auto bin = dynamic_cast<BinExpr*>(node)) {
+          ASTBinOp op{};
+          if (!toBinOp(bin->GetOp(), op)) return 0; // The parser only builds the operators above
+          kind = ASTNodeKind::Bin;
+          flags = (uint16_t)op;
+          children = { write(bin->GetLeft()), write(bin->GetRight()) };
+        }
+        else if (auto assign = dynamic_cast<AssignmentExpr*>(node)) {
+          kind = ASTNodeKind::Assignment;
+          children = { write(assign->GetAssigne()), write(assign->GetValue()) };
+        }
+        else if (auto call = dynamic_cast<CallExpr*>(node)) {
+          kind = ASTNodeKind::Call;
+          strings = { intern(call->GetCallee()) };
+          for (auto &arg : call->GetArgs()) children.push_back(write(arg.get()));
+        }
+        else if (auto spawn = dynamic_cast<SpawnExpr*>(node)) {
+          kind = ASTNodeKind::Spawn;
+          children = { write(spawn->GetBody()) };
+        }
+        else if (auto index = dynamic_cast<IndexExpr*>(node)) {
+          kind = ASTNodeKind::Index;
+          children = { write(index->GetBase()), write(index->GetIndex()) };
+        }
+        else if (auto member = dynamic_cast<MemberExpr*>(node)) {
+          kind = ASTNodeKind::Member;
+          strings = { intern(member->GetField().value.value_or("")) };
+          children = { write(member->GetBase()) };
+        }
+        else if (auto decl = dynamic_cast<VarDeclStmt*>(node)) {
+          kind = ASTNodeKind::VarDecl;
+          strings = { intern(decl->GetIdent().value.value_or("")) };
+          for (auto &type : decl->GetTypes()) strings.push_back(intern(type));
+          children = { write(decl->GetValue()) };
+        }
+        else if (auto array = dynamic_cast<ArrayDeclStmt*>(node)) {
+          kind = ASTNodeKind::ArrayDecl;
+          strings = { intern(array->GetIdent().value.value_or("")) };
+          for (auto &type : array->GetTypes()) strings.push_back(intern(type));
+          children = { write(array->GetSize()) };
+        }
+        else if (auto decl = dynamic_cast<StructDeclStmt*>(node)) {
+          kind = ASTNodeKind::StructDecl;
+          flags = decl->IsSoA() ? 1 : 0;
+          strings = { intern(decl->GetIdent().value.value_or("")) };
+          for (auto &field : decl->GetFields()) {
+            std::vector<uint32_t> fieldStrings = { intern(field.Ident.value.value_or("")) };
+            for (auto &type : field.Types) fieldStrings.push_back(intern(type));
+            children.push_back(emit(ASTNodeKind::Field, 0, {}, fieldStrings));
+          }
+        }
+        else if (auto scope = dynamic_cast<ScopeStmt*>(node)) {
+          kind = ASTNodeKind::Scope;
+          for (auto &stmt : scope->GetStatements()) children.push_back(write(stmt.get()));
+        }
+        else if (auto join = dynamic_cast<JoinStmt*>(node)) {
+          kind = ASTNodeKind::Join;
+          children = { write(join->GetHandle()) };
+        }
+        else if (auto loop = dynamic_cast<ForStmt*>(node)) {
+          kind = ASTNodeKind::For;
+          flags = loop->IsParallel() ? 1 : 0;
+          strings = { intern(loop->GetIdent().value.value_or("")) };
+          children = { write(loop->GetBegin()), write(loop->GetEnd()), write(loop->GetBody()) };
+        }
+        else return 0; // Unknown statements are dropped like missing ones
+
+        return emit(kind, flags, children, strings);
+      }
+
+      uint32_t emit(ASTNodeKind kind, uint16_t flags, const std::vector<uint32_t> &children, const std::vector<uint32_t> &strings) {
+        ASTNodeHeader header{ (uint16_t)kind, flags, (uint32_t)children.size(), (uint32_t)strings.size() };
+        size_t offset = m_Nodes.size();
+        m_Nodes.resize(offset + sizeof(header) + (children.size() + strings.size()) * sizeof(uint32_t));
+
+        uint8_t *dst = &m_Nodes[offset];
+        std::memcpy(dst, &header, sizeof(header));
+        dst += sizeof(header);
+        if (!children.empty()) std::memcpy(dst, children.data(), children.size() * sizeof(uint32_t));
+        dst += children.size() * sizeof(uint32_t);
+        if (!strings.empty()) std::memcpy(dst, strings.data(), strings.size() * sizeof(uint32_t));
+        return offset;
+      }
+
+      uint32_t intern(const std::string &str) {
+        auto [it, inserted] = m_Interned.try_emplace(str, (uint32_t)m_Strings.size());
+        if (inserted) m_Strings.push_back(&it->first);
+        return it->second;
+      }
+    private:
+      std::vector<uint8_t> m_Nodes{}; // Starts with room for the header
+      std::unordered_map<std::string, uint32_t> m_Interned{};
+      std::vector<const std::string*> m_Strings{}; // Keys of m_Interned by index
+    };
+
+  }
+
+  std::vector<uint8_t> SerializeAST(ProgNode *prog) {
+    return Writer().Finish(prog);
+  }
+
+  bool WriteAST(ProgNode *prog, const std::string &filepath) {
+    auto data = SerializeAST(prog);
+    if (data.empty()) return false;
+
+    std::ofstream file(filepath, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return (bool)file;
+  }
+  // =============== [ Writer ] ===============
+
+  // =============== [ Reader ] ===============
+  ASTNode ASTNode::GetChild(size_t i) const {
+    if (i >= m_Header->ChildCount || items()[i] == 0) return {};
+    return ASTNode(m_Base, items()[i]);
+  }
+
+  std::string_view ASTNode::GetString(size_t i) const {
+    if (i >= m_Header->StringCount) return {};
+    auto header = reinterpret_cast<const ASTFileHeader*>(m_Base);
+    auto &str = reinterpret_cast<const ASTString*>(m_Base + header->StringsOffset)[items()[m_Header->ChildCount + i]];
+    return std::string_view(reinterpret_cast<const char*>(m_Base) + str.Offset, str.Length);
+  }
+
+  bool ASTView::Open(const void *data, size_t size, std::string *error) {
+    auto fail = [&](const char *message) {
+      if (error) *error = message;
+      m_Data = nullptr;
+      return false;
+    };
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    if (((uintptr_t)bytes & 3) != 0) return fail("Buffer isn't 4-byte aligned!");
+    if (size < sizeof(ASTFileHeader)) return fail("Too small to be a binary AST!");
+
+    auto header = reinterpret_cast<const ASTFileHeader*>(bytes);
+    if (std::memcmp(header->Magic, Magic, sizeof(Magic)) != 0) return fail("Not a binary AST!");
+    if (header->Version != ASTVersion) return fail("Unsupported binary AST version!");
+    if (header->ByteOrder != ByteOrder) return fail("Binary AST was written with a different byte order!");
+    if (header->Size != size) return fail("Binary AST is truncated!");
+    if (checksum(bytes + sizeof(ASTFileHeader), size - sizeof(ASTFileHeader)) != header->Checksum)
+      return fail("Checksum mismatch!");
+
+    // Offsets are checked in 64 bits, a corrupt header can't wrap them around
+    uint64_t nodesEnd = (uint64_t)header->NodesOffset + header->NodesSize;
+    uint64_t stringsEnd = (uint64_t)header->StringsOffset + (uint64_t)header->StringCount * sizeof(ASTString);
+    if (header->NodesOffset != sizeof(ASTFileHeader) || (header->NodesSize & 3) || nodesEnd > size ||
+        header->StringsOffset < nodesEnd || (header->StringsOffset & 3) || stringsEnd > size)
+      return fail("Corrupt section offsets!");
+
+    auto strings = reinterpret_cast<const ASTString*>(bytes + header->StringsOffset);
+    for (uint32_t i = 0; i < header->StringCount; ++i)
+      if ((uint64_t)strings[i].Offset + strings[i].Length > size) return fail("Corrupt string table!");
+
+    // Children come before their parents, so each one has to be a node start already seen
+    std::vector<bool> starts(size / 4, false);
+    for (uint64_t pos = header->NodesOffset; pos < nodesEnd;) {
+      if (pos + sizeof(ASTNodeHeader) > nodesEnd) return fail("Corrupt node!");
+      auto node = reinterpret_cast<const ASTNodeHeader*>(bytes + pos);
+      uint64_t items = (uint64_t)node->ChildCount + node->StringCount;
+      uint64_t next = pos + sizeof(ASTNodeHeader) + items * sizeof(uint32_t);
+      if (node->Kind >= (uint16_t)ASTNodeKind::Count || next > nodesEnd) return fail("Corrupt node!");
+      if (node->Kind == (uint16_t)ASTNodeKind::Bin && node->Flags >= (uint16_t)ASTBinOp::Count) return fail("Corrupt operator!");
+
+      auto values = reinterpret_cast<const uint32_t*>(node + 1);
+      for (uint32_t i = 0; i < node->ChildCount; ++i)
+        if (values[i] != 0 && (values[i] & 3 || values[i] >= pos || !starts[values[i] / 4])) return fail("Corrupt child offset!");
+      for (uint32_t i = 0; i < node->StringCount; ++i)
+        if (values[node->ChildCount + i] >= header->StringCount) return fail("Corrupt string index!");
+
+      starts[pos / 4] = true;
+      pos = next;
+    }
+
+    if ((header->Root & 3) || header->Root >= nodesEnd || !starts[header->Root / 4] ||
+        reinterpret_cast<const ASTNodeHeader*>(bytes + header->Root)->Kind != (uint16_t)ASTNodeKind::Prog)
+      return fail("Corrupt root node!");
+
+    m_Data = bytes;
+    return true;
+  }
+
+  ASTNode ASTView::GetRoot() const {
+    if (!m_Data) return {};
+    return ASTNode(m_Data, reinterpret_cast<const ASTFileHeader*>(m_Data)->Root);
+  }
+
+  ASTFile::ASTFile(const std::string &filepath) {
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+      m_Error = Concat("Failed to open file \"", filepath, "\"!");
+      return;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      m_Size = info.st_size;
+      m_Mapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m_Mapping == MAP_FAILED) m_Mapping = nullptr;
+    }
+    close(fd);
+
+    if (!m_Mapping) m_Error = Concat("Failed to map file \"", filepath, "\"!");
+    else m_View.Open(m_Mapping, m_Size, &m_Error);
+  }
+
+  ASTFile::~ASTFile() {
+    if (m_Mapping) munmap(m_Mapping, m_Size);
+  }
+  // =============== [ Reader ] ===============
+
+}
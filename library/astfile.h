@@ -0,0 +1,144 @@
+#ifndef ULANG_ASTFILE_H
+#define ULANG_ASTFILE_H
+
+#include "parser.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace UraniumLang {
+
+  // =============== [ Binary AST ] ===============
+  // Parsed programs written to a flat buffer other tools can map and read in place.
+  // Layout, every offset is from the start of the file and 4-byte aligned:
+  //   ASTFileHeader
+  //   Nodes:   ASTNodeHeader, uint32_t Children[ChildCount], uint32_t Strings[StringCount]
+  //            children are written before their parent, so their offsets are always lower
+  //   Strings: ASTString[StringCount] (interned, each used once) followed by the characters
+  // A child offset of 0 is a missing node, e.g. a declaration without a value.
+  // Numbers are stored in the byte order of the writer, other hosts reject the file.
+
+  // Bump when the layout or the meaning of a kind or flag changes, new kinds and operators go at the end.
+  // 2: operators stored as ASTBinOp instead of Token::Type
+  constexpr uint16_t ASTVersion = 2;
+
+  enum class ASTNodeKind : uint16_t {
+    Prog,        // children: statements
+    Ident,       // strings: symbol
+    NumLit,      // strings: value as written
+    StrLit,      // strings: value
+    Bin,         // flags: ASTBinOp, children: left, right
+    Assignment,  // children: target, value
+    Call,        // strings: callee, children: arguments
+    Spawn,       // children: body
+    Index,       // children: base, index
+    Member,      // strings: field, children: base
+    VarDecl,     // strings: name, types..., children: value
+    ArrayDecl,   // strings: name, types..., children: size
+    StructDecl,  // flags: 1 = soa, strings: name, children: fields
+    Field,       // strings: name, types...
+    Scope,       // children: statements
+    Join,        // children: handle
+    For,         // flags: 1 = parallel, strings: index, children: begin, end, body
+    Count
+  };
+
+  // Operators have their own numbering, so new tokens don't change what stored files mean
+  enum class ASTBinOp : uint16_t {
+    Add, Sub, Mul, Div,
+    Count
+  };
+
+  struct ASTFileHeader {
+    char Magic[4];      // "UAST"
+    uint16_t Version;   // ASTVersion
+    uint16_t ByteOrder; // 0x0102 on the writer
+    uint32_t Size;      // Whole file
+    uint32_t Checksum;  // FNV-1a of everything after the header
+    uint32_t Root;      // Prog node
+    uint32_t NodesOffset, NodesSize;
+    uint32_t StringsOffset, StringCount;
+  };
+
+  struct ASTNodeHeader {
+    uint16_t Kind;
+    uint16_t Flags;
+    uint32_t ChildCount, StringCount;
+  };
+
+  struct ASTString {
+    uint32_t Offset, Length;
+  };
+
+  // Returns an empty buffer if the program doesn't fit the 4 GB the offsets can address
+  std::vector<uint8_t> SerializeAST(ProgNode *prog);
+  bool WriteAST(ProgNode *prog, const std::string &filepath);
+
+  // Read-only node inside a validated buffer, copying it is free
+  class ASTNode {
+  public:
+    ASTNode() = default;
+
+    inline explicit operator bool() const { return m_Header != nullptr; }
+
+    inline ASTNodeKind GetKind() const { return (ASTNodeKind)m_Header->Kind; }
+    inline uint16_t GetFlags() const { return m_Header->Flags; }
+
+    inline size_t GetChildCount() const { return m_Header->ChildCount; }
+    // Empty node if the child is missing or i is out of range
+    ASTNode GetChild(size_t i) const;
+
+    inline size_t GetStringCount() const { return m_Header->StringCount; }
+    // Points into the buffer, empty if i is out of range
+    std::string_view GetString(size_t i) const;
+  private:
+    friend class ASTView;
+    ASTNode(const uint8_t *base, uint32_t offset)
+      : m_Base(base), m_Header(reinterpret_cast<const ASTNodeHeader*>(base + offset)) {}
+
+    inline const uint32_t *items() const { return reinterpret_cast<const uint32_t*>(m_Header + 1); }
+  private:
+    const uint8_t *m_Base = nullptr;
+    const ASTNodeHeader *m_Header = nullptr;
+  };
+
+  // Binary AST in memory owned by someone else (e.g. ASTFile)
+  class ASTView {
+  public:
+    ASTView() = default;
+
+    // Checks the header, checksum and every node once, so nodes can be read without checks afterwards.
+    // data has to be 4-byte aligned and outlive the view.
+    bool Open(const void *data, size_t size, std::string *error = nullptr);
+
+    inline bool IsOpen() const { return m_Data != nullptr; }
+    ASTNode GetRoot() const;
+  private:
+    const uint8_t *m_Data = nullptr;
+  };
+
+  // Maps a file written by WriteAST() read-only
+  class ASTFile {
+  public:
+    ASTFile(const std::string &filepath);
+    ~ASTFile();
+
+    ASTFile(const ASTFile &) = delete;
+    ASTFile &operator=(const ASTFile &) = delete;
+
+    inline bool IsValid() const { return m_View.IsOpen(); }
+    inline const std::string &GetError() const { return m_Error; }
+    inline ASTNode GetRoot() const { return m_View.GetRoot(); }
+  private:
+    void *m_Mapping = nullptr;
+    size_t m_Size = 0;
+    ASTView m_View{};
+    std::string m_Error{};
+  };
+  // =============== [ Binary AST ] ===============
+
+}
+
+#endif
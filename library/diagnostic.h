@@ -0,0 +1,37 @@
+#ifndef ULANG_DIAGNOSTIC_H
+#define ULANG_DIAGNOSTIC_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace UraniumLang {
+
+  // Problem found in the source, reported instead of thrown so one pass finds all of them
+  struct Diagnostic {
+    int Line = 0, Column = 0; // 1-based, 0 = no position
+    std::string Message{};
+
+    friend std::ostream &operator <<(std::ostream &os, const Diagnostic &diag) {
+      if (diag.Line > 0) os << diag.Line << ":" << diag.Column << ": ";
+      return os << diag.Message;
+    }
+  };
+
+  // Joins parts with a single allocation, messages are built on every error
+  // so chains of operator+ temporaries add up on error-dense input
+  template <typename... Parts>
+  std::string Concat(const Parts &...parts) {
+    std::string_view views[] = { std::string_view(parts)... };
+    size_t size = 0;
+    for (auto view : views) size += view.size();
+
+    std::string res{};
+    res.reserve(size);
+    for (auto view : views) res.append(view);
+    return res;
+  }
+
+}
+
+#endif
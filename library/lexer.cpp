@@ -2,26 +2,24 @@
 
 #include <fstream>
 
-// TODO: Create custom exceptions
-
 namespace UraniumLang {
 
-  Lexer::Lexer(const std::string &filepath) {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-      throw std::runtime_error("Failed to read file \"" + filepath + "\"!");
-      return;
-    }
+  static constexpr std::string_view Punctuation = "(){}[]<>;:,.=+-*/!?";
 
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    m_Content = std::string(size, ' ');
-    file.seekg(0);
-    file.read(&m_Content[0], size);
+  Lexer::Lexer(const std::string &filepath, size_t chunkSize)
+    : Lexer(std::make_unique<std::ifstream>(filepath, std::ios::binary), chunkSize) {
+    if (!*m_Input) {
+      m_Diagnostics.push_back({ 0, 0, Concat("Failed to read file \"", filepath, "\"!") });
+      m_Input.reset();
+    }
   }
 
+  Lexer::Lexer(uptr<std::istream> input, size_t chunkSize)
+    : m_Input(std::move(input)), m_ChunkSize(chunkSize ? chunkSize : DefaultChunkSize) {}
+
   void Lexer::SetContent(const std::string &content) {
     m_Content = content;
+    m_Input.reset();
   }
 
   std::vector<Token> Lexer::GetTokens() {
@@ -42,6 +40,20 @@ namespace UraniumLang {
     Token tok{};
     tok.type = Token::Type::TOKN_EOF;
     skipSpaces();
+
+    // Report each run of unknown characters once and continue after it
+    while (isUnknown()) {
+      Diagnostic diag{ (int)m_Line + 1, (int)m_Column, {} };
+      std::string chars{}; // The run may continue into the next chunk
+      while (isUnknown()) {
+        chars += m_Char;
+        advance();
+      }
+      diag.Message = Concat("Unexpected character(s) \"", chars, "\"!");
+      m_Diagnostics.push_back(std::move(diag));
+      skipSpaces();
+    }
+
     tok.line = m_Line;
     tok.col = m_Column;
     if (m_Index >= m_Content.size() && m_Char == '\0') return tok;
@@ -55,10 +67,10 @@ namespace UraniumLang {
       }
     }
 
-    else if (isalnum(m_Char)) {
+    else if (isalnum(m_Char) || m_Char == '_') {
       tok.type = Token::Type::TOKN_ID;
       tok.value = "";
-      while (isalnum(m_Char)) {
+      while (isalnum(m_Char) || m_Char == '_') {
         tok.value.value() += m_Char;
         advance();
       }
@@ -67,12 +79,15 @@ namespace UraniumLang {
     else if (m_Char == '"') {
       tok.value = "";
       advance();
-      while (m_Char != '"' && m_Index < m_Content.size()) {
+      // m_Index only covers the current chunk, advance() refills before the end is reached
+      while (m_Char != '"' && !(m_Index >= m_Content.size() && m_Char == '\0')) {
         tok.value.value() += m_Char;
         advance();
       }
       if (m_Char != '"') {
-        throw std::runtime_error("Unexpected End Of File ");
+        // Everything up to the end of the file went into the literal
+        m_Diagnostics.push_back({ tok.line + 1, tok.col, "Unterminated string literal!" });
+        tok.value.reset();
       } else {
         tok.type = Token::Type::TOKN_STRING;
         advance();
@@ -82,14 +97,24 @@ namespace UraniumLang {
     else if (m_Char == '\'') {
       tok.value = "";
       advance();
-      tok.value.value() += m_Char;
-      if (m_Char == '\\') {
-        advance();
+      if (m_Char == '\'') m_Diagnostics.push_back({ tok.line + 1, tok.col, "Empty character literal!" });
+      else {
         tok.value.value() += m_Char;
+        if (m_Char == '\\') {
+          advance();
+          tok.value.value() += m_Char;
+        }
+        advance();
       }
-      advance();
-      if (m_Char != '\'') { throw std::runtime_error(std::string("Unexpected character '")+m_Char+"' at " + std::to_string(m_Line) + ":" + std::to_string(m_Column) + ", expected: `'`!"); return tok; }
-      advance();
+      if (m_Char != '\'') {
+        if (m_Char == '\n' || (m_Index >= m_Content.size() && m_Char == '\0'))
+          m_Diagnostics.push_back({ tok.line + 1, tok.col, "Unterminated character literal!" });
+        else
+          m_Diagnostics.push_back({ (int)m_Line + 1, (int)m_Column, Concat("Unexpected character '", std::string_view(&m_Char, 1), "', expected: `'`!") });
+        // Skip the rest of the literal, otherwise its closing quote would open another one
+        while (m_Char != '\'' && m_Char != '\n' && !(m_Index >= m_Content.size() && m_Char == '\0')) advance();
+      }
+      if (m_Char == '\'') advance();
       tok.type = Token::Type::TOKN_CHAR;
     }
 
@@ -105,6 +130,8 @@ namespace UraniumLang {
       case '>': { tok.type = Token::Type::TOKN_GT; } break;
       case ';': { tok.type = Token::Type::TOKN_SEMI; } break;
       case ':': { tok.type = Token::Type::TOKN_COLON; } break;
+      case ',': { tok.type = Token::Type::TOKN_COMMA; } break;
+      case '.': { tok.type = Token::Type::TOKN_DOT; } break;
       case '=': { tok.type = Token::Type::TOKN_EQUALS; } break;
       case '+': { tok.type = Token::Type::TOKN_PLUS; } break;
       case '-': { tok.type = Token::Type::TOKN_MINUS; } break;
@@ -112,7 +139,7 @@ namespace UraniumLang {
       case '/': { tok.type = Token::Type::TOKN_FSLASH; } break;
       case '!': { tok.type = Token::Type::TOKN_EXMARK; } break;
       case '?': { tok.type = Token::Type::TOKN_QUMARK; } break;
-      default: { throw std::runtime_error(std::string("Unexpected character '") + m_Char + "' at " + std::to_string(m_Line) + ":" + std::to_string(m_Column)); }
+      default: break; // Unknown characters were skipped above
       }
       advance();
     }
@@ -120,13 +147,31 @@ namespace UraniumLang {
     return tok;
   }
 
+  // Tokens are built one character at a time, so one crossing a chunk boundary
+  // simply carries on in the next chunk
   void Lexer::advance() {
+    if (m_Index >= m_Content.size() && m_Input) refill();
     if (m_Content.size() <= m_Index && m_Char == '\0') return;
     m_Char = m_Content[m_Index++];
     m_Column++;
     if (m_Char == '\n') { m_Line++; m_Column = 0; }
   }
 
+  bool Lexer::refill() {
+    if (!*m_Input) return false;
+    m_Content.resize(m_ChunkSize); // Keeps its capacity, no allocation after the first chunk
+    m_Input->read(&m_Content[0], m_ChunkSize);
+    m_Content.resize(m_Input->gcount());
+    m_Index = 0;
+    return !m_Content.empty();
+  }
+
+  bool Lexer::isUnknown() {
+    if (m_Index >= m_Content.size() && m_Char == '\0') return false;
+    return !isalnum(m_Char) && m_Char != '_' && m_Char != '"' && m_Char != '\'' && !isspace(m_Char) &&
+           Punctuation.find(m_Char) == std::string_view::npos;
+  }
+
   void Lexer::skipSpaces() {
     while (m_Char == ' ' || m_Char == '\t' || m_Char == '\n' || iswspace(m_Char) || isspace(m_Char) || m_Char == '\r') advance();
   }
@@ -2,8 +2,10 @@
 #define ULANG_LEXER_H
 
 #include "utilities.h" // TODO: Use
+#include "diagnostic.h"
 
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <optional>
 
@@ -15,7 +17,7 @@ namespace UraniumLang {
       TOKN_NUM, TOKN_STRING, TOKN_CHAR,
       TOKN_LPAREN, TOKN_RPAREN, TOKN_LBRACE, TOKN_RBRACE, TOKN_LBRACKET, TOKN_RBRACKET,
       TOKN_LT, TOKN_GT, // TOKN_LessThan (<), TOKN_GraterThank (>)
-      TOKN_SEMI, TOKN_COLON,
+      TOKN_SEMI, TOKN_COLON, TOKN_COMMA, TOKN_DOT,
       TOKN_EQUALS, TOKN_PLUS, TOKN_MINUS, TOKN_STAR, TOKN_FSLASH, TOKN_EXMARK, TOKN_QUMARK,
       TOKN_EOF
     } type;
@@ -38,6 +40,8 @@ namespace UraniumLang {
       case Type::TOKN_GT:       return "TOKN_GT";
       case Type::TOKN_SEMI:     return "TOKN_SEMI";
       case Type::TOKN_COLON:    return "TOKN_COLON";
+      case Type::TOKN_COMMA:    return "TOKN_COMMA";
+      case Type::TOKN_DOT:      return "TOKN_DOT";
       case Type::TOKN_EQUALS:   return "TOKN_EQUALS";
       case Type::TOKN_PLUS:     return "TOKN_PLUS";
       case Type::TOKN_MINUS:    return "TOKN_MINUS";
@@ -58,19 +62,38 @@ namespace UraniumLang {
 
   class Lexer {
   public:
+  static constexpr size_t DefaultChunkSize = 64 * 1024;
+
   Lexer() = default;
-  Lexer(const std::string &filepath);
+  // Files and streams are read chunkSize bytes at a time, memory use doesn't grow with their size
+  Lexer(const std::string &filepath, size_t chunkSize = DefaultChunkSize);
+  Lexer(uptr<std::istream> input, size_t chunkSize = DefaultChunkSize);
 
   void SetContent(const std::string &content);
   std::vector<Token> GetTokens();
-  private:
+  // Next token, TOKN_EOF once the input is exhausted
   Token GetTok();
+
+  // Problems found so far, the lexer skips over them and keeps going
+  inline const std::vector<Diagnostic> &GetDiagnostics() const { return m_Diagnostics; }
+  // Same, but hands them over so they aren't reported twice
+  inline std::vector<Diagnostic> TakeDiagnostics() {
+    std::vector<Diagnostic> diags{};
+    diags.swap(m_Diagnostics);
+    return diags;
+  }
+  private:
   void advance();
+  bool refill();
   void skipSpaces();
+  bool isUnknown(); // Character can't start any token
   private:
-    std::string m_Content = "";
+    std::string m_Content = ""; // Whole content or the current chunk of m_Input
+    uptr<std::istream> m_Input{};
+    size_t m_ChunkSize = DefaultChunkSize;
     char m_Char = ' ';
     size_t m_Index = 0, m_Line = 0, m_Column = 0;
+    std::vector<Diagnostic> m_Diagnostics{};
   };
 
 }
@@ -10,51 +10,160 @@ namespace UraniumLang {
 
   uptr<ProgNode> Parser::Parse() {
     std::vector<uptr<StmtNode>> statements{};
+    Parse([&](uptr<StmtNode> stmt) { statements.push_back(std::move(stmt)); });
+
+    return std::make_unique<ProgNode>(std::move(statements));
+  }
+
+  void Parser::Parse(const StatementConsumer &consumer) {
     while (m_CurTok.type != Token::Type::TOKN_EOF) {
       // std::cout << m_CurTok << std::endl;
-      statements.push_back(std::move(ParseStmt()));
+      if (auto stmt = ParseStmt()) consumer(std::move(stmt));
     }
-
-    return std::make_unique<ProgNode>(std::move(statements));
   }
 
   // private:
 
   void Parser::Initialize() {
-    m_Tokens = m_Lexer->GetTokens();
+    m_CurTok = pull();
+  }
 
-    m_CurTok = m_Tokens[m_Index = 0];
+  Token Parser::pull() {
+    auto tokn = m_Lexer->GetTok();
+    if (!m_Lexer->GetDiagnostics().empty()) {
+      for (auto &diag : m_Lexer->TakeDiagnostics()) m_Diagnostics.push_back(std::move(diag));
+      m_ReportedLine = tokn.line;
+      m_ReportedCol = tokn.col;
+    }
+    return tokn;
   }
 
   uptr<StmtNode> Parser::ParseStmt() {
     auto tokn = m_CurTok;
+    size_t errors = m_Diagnostics.size();
     uptr<StmtNode> res = nullptr;
 
-    if (tokn.type == Token::Type::TOKN_ID) {
-      if ((res = ParseVarDecl())) return res;
-    }
-    
-    res = ParseExpr();
-    expect(Token::Type::TOKN_SEMI);
+    if (tokn.type == Token::Type::TOKN_SEMI) advance(); // Empty statement
+    else if (tokn.type == Token::Type::TOKN_LBRACE) res = ParseScope();
+    else if (tokn.type == Token::Type::TOKN_ID && tokn.value.value() == "join") res = ParseJoin();
+    else if (tokn.type == Token::Type::TOKN_ID && (tokn.value.value() == "for" || tokn.value.value() == "parallel_for"))
+      res = ParseFor();
+    else if (tokn.type == Token::Type::TOKN_ID && (tokn.value.value() == "struct" || tokn.value.value() == "class"))
+      res = ParseStructDecl();
+    else if (tokn.type == Token::Type::TOKN_ID && tokn.value.value() == "soa" && peek(1).type == Token::Type::TOKN_ID &&
+             (peek(1).value.value() == "struct" || peek(1).value.value() == "class")) // Otherwise a plain identifier
+      res = ParseStructDecl();
+    else if (isType(tokn)) res = ParseVarDecl();
+    else if ((res = ParseExpr()) && !expect(Token::Type::TOKN_SEMI)) res = nullptr;
+
+    // Statements that recovered from errors inside them (e.g. in a nested scope) are kept
+    if (!res && m_Diagnostics.size() != errors) synchronize();
     return res;
   }
 
   uptr<StmtNode> Parser::ParseVarDecl() {
     auto types = ParseType();
-    if (types.empty()) return nullptr;
     auto name = expect(Token::Type::TOKN_ID);
+    if (!name) return nullptr;
     auto tokn = m_CurTok;
-    uptr<VarDeclStmt> res = nullptr;
+    uptr<StmtNode> res = nullptr;
     if (tokn.type == Token::Type::TOKN_EQUALS) {
-      expect(Token::Type::TOKN_EQUALS);
+      advance();
       auto expr = ParseExpr();
-      res = std::make_unique<VarDeclStmt>(name, std::move(expr));
+      if (!expr) return nullptr;
+      res = std::make_unique<VarDeclStmt>(*name, std::move(expr), types);
+    }
+    else if (tokn.type == Token::Type::TOKN_LBRACKET) {
+      advance();
+      auto size = ParseExpr();
+      if (!size || !expect(Token::Type::TOKN_RBRACKET)) return nullptr;
+      res = std::make_unique<ArrayDeclStmt>(*name, std::move(size), types);
     }
-    else if (tokn.type == Token::Type::TOKN_SEMI) res = std::make_unique<VarDeclStmt>(name, nullptr);
-    else throw std::runtime_error("Unexpected token \"" + Token::ToString(m_CurTok.type) + "\", expected \"TOKN_SEMI\" or \"TOKN_EQUALS\"!");
-    expect(Token::Type::TOKN_SEMI);
+    else if (tokn.type == Token::Type::TOKN_SEMI) res = std::make_unique<VarDeclStmt>(*name, nullptr, types);
+    else return error(tokn, "Unexpected token \"", Token::ToString(tokn.type), "\", expected \"TOKN_SEMI\" or \"TOKN_EQUALS\"!");
+    if (!expect(Token::Type::TOKN_SEMI)) return nullptr;
 
-    return res ? std::move(res) : nullptr;
+    return res;
+  }
+
+  uptr<StmtNode> Parser::ParseStructDecl() {
+    bool soa = false;
+    if (m_CurTok.value.value() == "soa") {
+      soa = true;
+      advance();
+    }
+    auto keyword = expect(Token::Type::TOKN_ID);
+    if (!keyword) return nullptr;
+    if (keyword->value.value() != "struct" && keyword->value.value() != "class")
+      return error(*keyword, "Expected \"struct\" or \"class\", but instead got \"", keyword->value.value(), "\"!");
+    auto name = expect(Token::Type::TOKN_ID);
+    if (!name || !expect(Token::Type::TOKN_LBRACE)) return nullptr;
+
+    // Known before the fields so a broken field doesn't turn later uses of the type into errors
+    m_StructTypes.insert(name->value.value());
+
+    m_ScopeDepth++;
+    std::vector<StructDeclStmt::Field> fields{};
+    while (m_CurTok.type != Token::Type::TOKN_RBRACE && m_CurTok.type != Token::Type::TOKN_EOF) {
+      // Access specifiers don't mean anything yet
+      if (m_CurTok.type == Token::Type::TOKN_ID && peek(1).type == Token::Type::TOKN_COLON &&
+          (m_CurTok.value.value() == "public" || m_CurTok.value.value() == "private")) {
+        advance();
+        advance();
+        continue;
+      }
+
+      StructDeclStmt::Field field{};
+      field.Types = ParseType();
+      std::optional<Token> ident{};
+      if (field.Types.empty())
+        error(m_CurTok, "Expected a field type, but instead got \"", Token::ToString(m_CurTok.type), "\"!");
+      else if ((ident = expect(Token::Type::TOKN_ID)) && expect(Token::Type::TOKN_SEMI)) {
+        field.Ident = *ident;
+        fields.push_back(field);
+        continue;
+      }
+      synchronize(); // Skip the broken field only
+    }
+    m_ScopeDepth--;
+    if (!expect(Token::Type::TOKN_RBRACE) || !expect(Token::Type::TOKN_SEMI)) return nullptr;
+
+    return std::make_unique<StructDeclStmt>(*name, std::move(fields), soa);
+  }
+
+  uptr<ScopeStmt> Parser::ParseScope() {
+    if (!expect(Token::Type::TOKN_LBRACE)) return nullptr;
+    std::vector<uptr<StmtNode>> statements{};
+    m_ScopeDepth++;
+    while (m_CurTok.type != Token::Type::TOKN_RBRACE && m_CurTok.type != Token::Type::TOKN_EOF)
+      if (auto stmt = ParseStmt()) statements.push_back(std::move(stmt));
+    m_ScopeDepth--;
+    if (!expect(Token::Type::TOKN_RBRACE)) return nullptr;
+
+    return std::make_unique<ScopeStmt>(std::move(statements));
+  }
+
+  uptr<StmtNode> Parser::ParseJoin() {
+    advance(); // join
+    auto handle = ParseExpr();
+    if (!handle || !expect(Token::Type::TOKN_SEMI)) return nullptr;
+
+    return std::make_unique<JoinStmt>(std::move(handle));
+  }
+
+  uptr<StmtNode> Parser::ParseFor() {
+    bool parallel = advance().value.value() == "parallel_for";
+    if (!expect(Token::Type::TOKN_LPAREN)) return nullptr;
+    auto ident = expect(Token::Type::TOKN_ID);
+    if (!ident || !expect(Token::Type::TOKN_EQUALS)) return nullptr;
+    auto begin = ParseExpr();
+    if (!begin || !expect(Token::Type::TOKN_COLON)) return nullptr;
+    auto end = ParseExpr();
+    if (!end || !expect(Token::Type::TOKN_RPAREN)) return nullptr;
+    auto body = ParseScope();
+    if (!body) return nullptr;
+
+    return std::make_unique<ForStmt>(*ident, std::move(begin), std::move(end), std::move(body), parallel);
   }
 
   uptr<ExprNode> Parser::ParseExpr() {
@@ -63,22 +172,29 @@ namespace UraniumLang {
 
   uptr<ExprNode> Parser::ParseAssignmentExpr() {
     auto left = ParseBinExpr();
+    if (!left) return nullptr;
     
     if (m_CurTok.type == Token::Type::TOKN_EQUALS) {
-      expect(Token::Type::TOKN_EQUALS);
+      advance();
+      auto value = ParseAssignmentExpr();
+      if (!value) return nullptr;
       
-      return std::make_unique<AssignmentExpr>(std::move(left), std::move(ParseAssignmentExpr()));
+      return std::make_unique<AssignmentExpr>(std::move(left), std::move(value));
     }
     
     return left;
   }
 
-  uptr<ExprNode> Parser::ParseBinExpr() {
+  uptr<ExprNode> Parser::ParseBinExpr(int minPrec) {
     auto left = ParsePrimExpr();
+    if (!left) return nullptr;
 
-    while (m_CurTok.type != Token::Type::TOKN_EOF && GetTokPrecedence(m_CurTok.type) >= 0) {
+    // Precedence climbing, operators of equal precedence are left associative
+    while (m_CurTok.type != Token::Type::TOKN_EOF && GetTokPrecedence(m_CurTok.type) >= minPrec) {
+      int prec = GetTokPrecedence(m_CurTok.type);
       auto op = advance().type;
-      auto right = ParsePrimExpr();
+      auto right = ParseBinExpr(prec + 1);
+      if (!right) return nullptr;
       left = std::make_unique<BinExpr>(std::move(left), std::move(right), op);
     }
 
@@ -90,17 +206,97 @@ namespace UraniumLang {
 
     switch (tknTy)
     {
-    case Token::Type::TOKN_ID:     return std::make_unique<IdentExpr>(advance().value.value());
+    case Token::Type::TOKN_ID: {
+      if (peek(1).type == Token::Type::TOKN_LPAREN) return ParseCallExpr();
+      if (m_CurTok.value.value() == "spawn" && peek(1).type == Token::Type::TOKN_LBRACE) return ParseSpawnExpr();
+      return ParsePostfixExpr(std::make_unique<IdentExpr>(advance().value.value()));
+    }
     case Token::Type::TOKN_NUM:    return std::make_unique<NumLitExpr>(advance());
     case Token::Type::TOKN_STRING: return std::make_unique<StrLitExpr>(advance());
-    default:                       return nullptr;
+    case Token::Type::TOKN_LPAREN: {
+      advance();
+      auto expr = ParseExpr();
+      if (!expr || !expect(Token::Type::TOKN_RPAREN)) return nullptr;
+      return expr;
+    }
+    default:                       return error(m_CurTok, "Expected an expression, but instead got token \"", Token::ToString(tknTy), "\"!");
+    }
+  }
+
+  uptr<ExprNode> Parser::ParseCallExpr() {
+    auto callee = advance();
+    advance(); // (
+    std::vector<uptr<ExprNode>> args{};
+    while (m_CurTok.type != Token::Type::TOKN_RPAREN && m_CurTok.type != Token::Type::TOKN_EOF) {
+      auto arg = ParseExpr();
+      if (!arg) return nullptr;
+      args.push_back(std::move(arg));
+      if (m_CurTok.type != Token::Type::TOKN_COMMA) break;
+      advance();
+    }
+    if (!expect(Token::Type::TOKN_RPAREN)) return nullptr;
+
+    return std::make_unique<CallExpr>(callee.value.value(), std::move(args));
+  }
+
+  uptr<ExprNode> Parser::ParseSpawnExpr() {
+    advance(); // spawn
+    auto body = ParseScope();
+    if (!body) return nullptr;
+    return std::make_unique<SpawnExpr>(std::move(body));
+  }
+
+  uptr<ExprNode> Parser::ParsePostfixExpr(uptr<ExprNode> base) {
+    while (true) {
+      if (m_CurTok.type == Token::Type::TOKN_LBRACKET) {
+        advance();
+        auto index = ParseExpr();
+        if (!index || !expect(Token::Type::TOKN_RBRACKET)) return nullptr;
+        base = std::make_unique<IndexExpr>(std::move(base), std::move(index));
+      }
+      else if (m_CurTok.type == Token::Type::TOKN_DOT) {
+        advance();
+        auto field = expect(Token::Type::TOKN_ID);
+        if (!field) return nullptr;
+        base = std::make_unique<MemberExpr>(std::move(base), *field);
+      }
+      else return base;
     }
   }
 
   std::vector<std::string> Parser::ParseType() {
     std::vector<std::string> types{};
-    while (m_CurTok.type == Token::Type::TOKN_ID && Types.find(m_CurTok.value.value()) != Types.end()) types.push_back(advance().value.value());
+    while (isType(m_CurTok))
+      types.push_back(advance().value.value());
     return types;
   }
 
+  bool Parser::isType(const Token &tokn) {
+    return tokn.type == Token::Type::TOKN_ID &&
+           (Types.find(tokn.value.value()) != Types.end() || m_StructTypes.count(tokn.value.value()));
+  }
+
+  void Parser::synchronize() {
+    size_t open = 0; // Blocks opened by the skipped tokens
+    while (m_CurTok.type != Token::Type::TOKN_EOF) {
+      if (m_CurTok.type == Token::Type::TOKN_LBRACE) open++;
+      else if (m_CurTok.type == Token::Type::TOKN_SEMI && open == 0) {
+        advance();
+        return;
+      }
+      else if (m_CurTok.type == Token::Type::TOKN_RBRACE) {
+        if (open > 0) {
+          // A skipped block ends the broken statement (e.g. a loop body)
+          advance();
+          if (--open == 0) return;
+          continue;
+        }
+        // Closes an enclosing scope, leave it to that scope; a stray one at the top level is skipped
+        if (m_ScopeDepth == 0) advance();
+        return;
+      }
+      advance();
+    }
+  }
+
 }
@@ -5,18 +5,31 @@
 
 #include "lexer.h"
 
+#include <array>
+#include <cassert>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <map>
 #include <memory>
+#include <set>
 
 // =============== [ AST Nodes ] ===============
 //  Statements:
 //   - Variable Declaration Statement
+//   - Array Declaration Statement
+//   - Struct Declaration Statement
+//   - Scope Statement
+//   - Join Statement
+//   - For Statement (for / parallel_for)
 //  Expressions:
 //   - Identifier Expression
 //   - Number Literal Expression
 //   - Binary Expression
+//   - Call Expression
+//   - Spawn Expression
+//   - Index Expression
+//   - Member Expression
 // =============== [ AST Nodes ] ===============
 
 namespace UraniumLang {
@@ -33,10 +46,14 @@ namespace UraniumLang {
   private:
   };
 
+  class ScopeStmt;
+
   // =============== [ Exprs ] ===============
   class IdentExpr : public ExprNode {
   public:
     IdentExpr(const std::string &symbol) : m_Symbol(symbol) {}
+
+    inline const std::string &GetSymbol() { return m_Symbol; }
   private:
     std::string m_Symbol{};
   };
@@ -44,6 +61,8 @@ namespace UraniumLang {
   class NumLitExpr : public ExprNode {
   public:
     NumLitExpr(const Token &value) : m_Value(value) {}
+
+    inline const Token &GetValue() { return m_Value; }
   private:
     Token m_Value;
   };
@@ -51,6 +70,8 @@ namespace UraniumLang {
   class StrLitExpr : public ExprNode {
   public:
     StrLitExpr(const Token &value) : m_Value(value) {}
+
+    inline const Token &GetValue() { return m_Value; }
   private:
     Token m_Value;
   };
@@ -59,6 +80,10 @@ namespace UraniumLang {
   public:
     BinExpr(uptr<ExprNode> left, uptr<ExprNode> right, Token::Type op)
       : m_Left(std::move(left)), m_Right(std::move(right)), m_Op(op) {}
+
+    inline ExprNode *GetLeft() { return m_Left.get(); }
+    inline ExprNode *GetRight() { return m_Right.get(); }
+    inline Token::Type GetOp() { return m_Op; }
   private:
     uptr<ExprNode> m_Left{}, m_Right{};
     Token::Type m_Op{};
@@ -67,20 +92,154 @@ namespace UraniumLang {
   class AssignmentExpr : public ExprNode {
   public:
     AssignmentExpr(uptr<ExprNode> assigne, uptr<ExprNode> value) : m_Assigne(std::move(assigne)), m_Value(std::move(value)) {}
+
+    inline ExprNode *GetAssigne() { return m_Assigne.get(); }
+    inline ExprNode *GetValue() { return m_Value.get(); }
   private:
     uptr<ExprNode> m_Assigne{}, m_Value{};
   };
+
+  class CallExpr : public ExprNode {
+  public:
+    CallExpr(const std::string &callee, std::vector<uptr<ExprNode>> args)
+      : m_Callee(callee), m_Args(std::move(args)) {}
+
+    inline const std::string &GetCallee() { return m_Callee; }
+    inline const std::vector<uptr<ExprNode>> &GetArgs() { return m_Args; }
+  private:
+    std::string m_Callee{};
+    std::vector<uptr<ExprNode>> m_Args{};
+  };
+
+  // array[index]
+  class IndexExpr : public ExprNode {
+  public:
+    IndexExpr(uptr<ExprNode> base, uptr<ExprNode> index) : m_Base(std::move(base)), m_Index(std::move(index)) {}
+
+    inline ExprNode *GetBase() { return m_Base.get(); }
+    inline ExprNode *GetIndex() { return m_Index.get(); }
+  private:
+    uptr<ExprNode> m_Base{}, m_Index{};
+  };
+
+  // object.field
+  class MemberExpr : public ExprNode {
+  public:
+    MemberExpr(uptr<ExprNode> base, Token field) : m_Base(std::move(base)), m_Field(field) {}
+
+    inline ExprNode *GetBase() { return m_Base.get(); }
+    inline const Token &GetField() { return m_Field; }
+  private:
+    uptr<ExprNode> m_Base{};
+    Token m_Field{};
+  };
+
+  // spawn { ... }, evaluates to a handle that has to be joined
+  class SpawnExpr : public ExprNode {
+  public:
+    SpawnExpr(uptr<ScopeStmt> body);
+    ~SpawnExpr();
+
+    inline ScopeStmt *GetBody() { return m_Body.get(); }
+  private:
+    uptr<ScopeStmt> m_Body{};
+  };
   // =============== [ Exprs ] ===============
 
   // =============== [ Stmts ] ===============
   class VarDeclStmt : public StmtNode {
   public:
-    VarDeclStmt(Token ident, uptr<ExprNode> value) : m_Ident(ident), m_Value(std::move(value)) {}
+    VarDeclStmt(Token ident, uptr<ExprNode> value, std::vector<std::string> types = {})
+      : m_Ident(ident), m_Value(std::move(value)), m_Types(std::move(types)) {}
+
+    inline const Token &GetIdent() { return m_Ident; }
+    inline ExprNode *GetValue() { return m_Value.get(); }
+    inline const std::vector<std::string> &GetTypes() { return m_Types; }
   private:
     Token m_Ident{};
     uptr<ExprNode> m_Value{};
+    std::vector<std::string> m_Types{};
+  };
+
+  // type name[size];
+  class ArrayDeclStmt : public StmtNode {
+  public:
+    ArrayDeclStmt(Token ident, uptr<ExprNode> size, std::vector<std::string> types)
+      : m_Ident(ident), m_Size(std::move(size)), m_Types(std::move(types)) {}
+
+    inline const Token &GetIdent() { return m_Ident; }
+    inline ExprNode *GetSize() { return m_Size.get(); }
+    inline const std::vector<std::string> &GetTypes() { return m_Types; }
+  private:
+    Token m_Ident{};
+    uptr<ExprNode> m_Size{};
+    std::vector<std::string> m_Types{};
   };
 
+  // [soa] struct Name { type field; ... };
+  //  soa: arrays of this type are stored as one array per field,
+  //       element access syntax stays the same
+  class StructDeclStmt : public StmtNode {
+  public:
+    struct Field {
+      std::vector<std::string> Types{};
+      Token Ident{};
+    };
+
+    StructDeclStmt(Token ident, std::vector<Field> fields, bool soa)
+      : m_Ident(ident), m_Fields(std::move(fields)), m_SoA(soa) {}
+
+    inline const Token &GetIdent() { return m_Ident; }
+    inline const std::vector<Field> &GetFields() { return m_Fields; }
+    inline bool IsSoA() { return m_SoA; }
+  private:
+    Token m_Ident{};
+    std::vector<Field> m_Fields{};
+    bool m_SoA = false;
+  };
+
+  class ScopeStmt : public StmtNode {
+  public:
+    ScopeStmt(std::vector<uptr<StmtNode>> stmts)
+      : m_Stmts(std::move(stmts)) {}
+
+    inline const std::vector<uptr<StmtNode>> &GetStatements() { return m_Stmts; }
+  private:
+    std::vector<uptr<StmtNode>> m_Stmts{};
+  };
+
+  // join handle;
+  class JoinStmt : public StmtNode {
+  public:
+    JoinStmt(uptr<ExprNode> handle) : m_Handle(std::move(handle)) {}
+
+    inline ExprNode *GetHandle() { return m_Handle.get(); }
+  private:
+    uptr<ExprNode> m_Handle{};
+  };
+
+  // for (i = begin : end) { ... }, i goes from begin up to end (exclusive)
+  // parallel_for: same, but iterations may run on any thread in any order
+  class ForStmt : public StmtNode {
+  public:
+    ForStmt(Token ident, uptr<ExprNode> begin, uptr<ExprNode> end, uptr<ScopeStmt> body, bool parallel)
+      : m_Ident(ident), m_Begin(std::move(begin)), m_End(std::move(end)), m_Body(std::move(body)), m_Parallel(parallel) {}
+
+    inline const Token &GetIdent() { return m_Ident; }
+    inline ExprNode *GetBegin() { return m_Begin.get(); }
+    inline ExprNode *GetEnd() { return m_End.get(); }
+    inline ScopeStmt *GetBody() { return m_Body.get(); }
+    inline bool IsParallel() { return m_Parallel; }
+  private:
+    Token m_Ident{};
+    uptr<ExprNode> m_Begin{}, m_End{};
+    uptr<ScopeStmt> m_Body{};
+    bool m_Parallel = false;
+  };
+
+  inline SpawnExpr::SpawnExpr(uptr<ScopeStmt> body) : m_Body(std::move(body)) {}
+  inline SpawnExpr::~SpawnExpr() = default;
+
   class ProgNode : public StmtNode {
   public:
     ProgNode(std::vector<uptr<StmtNode>> stmts)
@@ -134,7 +293,14 @@ namespace UraniumLang {
   Parser(const std::string &filepath);
   ~Parser() = default;
 
+  // Receives each top-level statement as soon as it is parsed
+  using StatementConsumer = std::function<void(uptr<StmtNode> stmt)>;
+
+  // Never throws, statements that fail to parse are left out and reported in GetDiagnostics()
   uptr<ProgNode> Parse();
+  // Same, but nothing is kept, memory use stays constant however long the input is
+  void Parse(const StatementConsumer &consumer);
+  inline const std::vector<Diagnostic> &GetDiagnostics() const { return m_Diagnostics; }
   
   private: // Functions
 
@@ -142,40 +308,81 @@ namespace UraniumLang {
   
   uptr<StmtNode> ParseStmt();
   uptr<StmtNode> ParseVarDecl();
+  uptr<StmtNode> ParseStructDecl();
+  uptr<ScopeStmt> ParseScope();
+  uptr<StmtNode> ParseJoin();
+  uptr<StmtNode> ParseFor();
   uptr<ExprNode> ParseExpr();
-  uptr<ExprNode> ParseBinExpr();
+  uptr<ExprNode> ParseBinExpr(int minPrec = 0);
   uptr<ExprNode> ParseAssignmentExpr();
   uptr<ExprNode> ParsePrimExpr();
+  uptr<ExprNode> ParseCallExpr();
+  uptr<ExprNode> ParseSpawnExpr();
+  uptr<ExprNode> ParsePostfixExpr(uptr<ExprNode> base);
   std::vector<std::string> ParseType();
 
+  bool isType(const Token &tokn);
+  // Panic-mode recovery: skips to the end of the broken statement
+  void synchronize();
+
   private:
 
   // Get current token without advancing
   // params:
-  //  - off: Offset (default = 0)
-  inline Token peek(size_t off = 0) {
-    return m_Tokens[m_Index+off];
+  //  - off: Offset (default = 0), less than Lookahead
+  inline const Token &peek(size_t off = 0) {
+    assert(off < Lookahead && "peek() past the lookahead would overwrite a token still in the ring");
+    if (off == 0) return m_CurTok;
+    while (m_Ahead < off) m_Ring[(m_Head + m_Ahead++) % Lookahead] = pull();
+    return m_Ring[(m_Head + off - 1) % Lookahead];
   }
 
   // Advance and get previous token
   inline Token advance() {
-    Token tokn = m_CurTok;
-    if (m_Tokens.size() > (m_Index+1)) m_CurTok = m_Tokens[++m_Index];
+    Token tokn = std::move(m_CurTok);
+    if (m_Ahead > 0) {
+      m_CurTok = std::move(m_Ring[m_Head]);
+      m_Head = (m_Head + 1) % Lookahead;
+      m_Ahead--;
+    }
+    else m_CurTok = pull();
     return tokn;
   }
 
-  inline Token expect(Token::Type type) {
-    auto tokn = advance();
-    if (tokn.type != type) throw std::runtime_error("Expected token \"" + Token::ToString(type) + "\", but instead got token \"" + Token::ToString(tokn.type) + "\"!");
-    return tokn;
+  // Next token from the lexer, along with anything it reported on the way
+  Token pull();
+
+  // Advance if the current token has the given type, report an error otherwise
+  inline std::optional<Token> expect(Token::Type type) {
+    if (m_CurTok.type != type) {
+      error(m_CurTok, "Expected token \"", Token::ToString(type), "\", but instead got token \"", Token::ToString(m_CurTok.type), "\"!");
+      return std::nullopt;
+    }
+    return advance();
+  }
+
+  // Records a diagnostic at tokn, returns nullptr so failed parse functions can return it.
+  // Tokens the lexer already reported (e.g. a broken char literal) aren't reported twice.
+  template <typename... Parts>
+  std::nullptr_t error(const Token &tokn, const Parts &...parts) {
+    if (tokn.line != m_ReportedLine || tokn.col != m_ReportedCol)
+      m_Diagnostics.push_back({ tokn.line + 1, tokn.col, Concat(parts...) });
+    return nullptr;
   }
   
   private:
   
-  size_t m_Index = 0;
+  // Tokens after m_CurTok that were peeked at, pulled from the lexer on demand
+  static constexpr size_t Lookahead = 4;
+  std::array<Token, Lookahead> m_Ring{};
+  size_t m_Head = 0, m_Ahead = 0;
+
+  size_t m_ScopeDepth = 0; // Braces synchronize() must not skip past
+  int m_ReportedLine = -1, m_ReportedCol = -1; // Last token the lexer reported a problem for
   Token m_CurTok{};
-  std::vector<Token> m_Tokens{};
+  std::set<std::string> m_StructTypes{}; // Declared so far, usable as types
   std::unique_ptr<Lexer> m_Lexer{};
+  std::vector<Diagnostic> m_Diagnostics{};
   
   };
 
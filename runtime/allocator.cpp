@@ -0,0 +1,414 @@
+#include "allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace UraniumLang {
+
+  namespace {
+
+    inline uintptr_t alignUp(uintptr_t value, size_t align) {
+      return (value + (align - 1)) & ~(uintptr_t)(align - 1);
+    }
+
+    inline void updatePeak(AllocStats &stats) {
+      if (stats.BytesInUse > stats.PeakBytes) stats.PeakBytes = stats.BytesInUse;
+    }
+
+  }
+
+  // =============== [ Frame Arena ] ===============
+  FrameArena::FrameArena(size_t capacity) {
+    if (capacity == 0) capacity = 1 << 20;
+    auto data = (uint8_t*)std::malloc(capacity);
+    if (!data) throw std::bad_alloc();
+    m_Blocks.push_back({ data, capacity });
+    m_Capacity = capacity;
+  }
+
+  FrameArena::~FrameArena() {
+    for (auto &block : m_Blocks) std::free(block.Data);
+  }
+
+  void *FrameArena::Alloc(size_t size, size_t align) {
+    if (align == 0 || (align & (align - 1)) != 0) return nullptr;
+
+    auto block = &m_Blocks[m_Current];
+    uintptr_t base = (uintptr_t)block->Data;
+    uintptr_t ptr = alignUp(base + m_Offset, align);
+    // Compared as remaining space, ptr + size can wrap for huge sizes
+    if (ptr - base > block->Size || size > block->Size - (ptr - base)) {
+      if (size > SIZE_MAX - align || !nextBlock(size + align)) return nullptr;
+      block = &m_Blocks[m_Current];
+      base = (uintptr_t)block->Data;
+      ptr = alignUp(base, align);
+    }
+
+    size_t consumed = (ptr + size) - (base + m_Offset);
+    m_Offset = (ptr + size) - base;
+    m_Used += consumed;
+
+    m_Stats.Allocations++;
+    m_Stats.BytesInUse = m_Used;
+    updatePeak(m_Stats);
+    return (void*)ptr;
+  }
+
+  void FrameArena::Reset() {
+    m_Current = 0;
+    m_Offset = 0;
+    m_Used = 0;
+    m_Stats.BytesInUse = 0;
+  }
+
+  // private:
+
+  bool FrameArena::nextBlock(size_t minSize) {
+    size_t next = m_Current + 1;
+    if (next < m_Blocks.size() && m_Blocks[next].Size >= minSize) {
+      m_Current = next;
+      m_Offset = 0;
+      return true;
+    }
+
+    size_t size = std::max(minSize, m_Blocks[m_Current].Size * 2);
+    auto data = (uint8_t*)std::malloc(size);
+    if (!data) return false;
+    m_Blocks.insert(m_Blocks.begin() + next, { data, size });
+    m_Capacity += size;
+    m_Current = next;
+    m_Offset = 0;
+    return true;
+  }
+  // =============== [ Frame Arena ] ===============
+
+  // =============== [ Object Pool ] ===============
+  Pool::Pool(size_t objectSize, size_t objectsPerChunk)
+    : m_ObjectsPerChunk(std::max<size_t>(objectsPerChunk, 1)) {
+    constexpr size_t align = alignof(std::max_align_t);
+    objectSize = std::max(objectSize, sizeof(FreeNode));
+    // A chunk has to fit in size_t, otherwise the pool stays invalid and Alloc() returns nullptr
+    if (objectSize > SIZE_MAX - align) return;
+    objectSize = alignUp(objectSize, align);
+    if (objectSize > SIZE_MAX / m_ObjectsPerChunk) return;
+    m_ObjectSize = objectSize;
+  }
+
+  Pool::~Pool() {
+    for (auto chunk : m_Chunks) std::free(chunk);
+  }
+
+  void *Pool::Alloc() {
+    if (!m_Free) grow();
+    if (!m_Free) return nullptr;
+
+    FreeNode *node = m_Free;
+    m_Free = node->Next;
+
+    m_Stats.Allocations++;
+    m_Stats.BytesInUse += m_ObjectSize;
+    updatePeak(m_Stats);
+    return node;
+  }
+
+  void Pool::Free(void *ptr) {
+    if (!ptr) return;
+    auto node = (FreeNode*)ptr;
+    node->Next = m_Free;
+    m_Free = node;
+
+    m_Stats.Frees++;
+    m_Stats.BytesInUse -= m_ObjectSize;
+  }
+
+  // private:
+
+  void Pool::grow() {
+    if (!IsValid()) return;
+    auto chunk = (uint8_t*)std::malloc(m_ObjectSize * m_ObjectsPerChunk);
+    if (!chunk) return;
+    m_Chunks.push_back(chunk);
+
+    for (size_t i = m_ObjectsPerChunk; i-- > 0;) {
+      auto node = (FreeNode*)(chunk + i * m_ObjectSize);
+      node->Next = m_Free;
+      m_Free = node;
+    }
+  }
+  // =============== [ Object Pool ] ===============
+
+  // =============== [ General Allocator ] ===============
+  namespace {
+
+    // Every block is prefixed with a header so Deallocate() knows where it came from.
+    // 16 bytes keeps the user pointer aligned to alignof(max_align_t).
+    struct alignas(16) BlockHeader {
+      uint32_t Class;
+      uint64_t Size;
+    };
+
+    constexpr size_t NumClasses = 9;     // 16, 32, ..., 4096
+    constexpr uint32_t LargeClass = ~0u;
+    constexpr size_t BatchSize = 32;     // Blocks moved between a thread cache and the shared list at once
+    constexpr size_t SlabSize = 64 * 1024;
+
+    inline size_t classSize(size_t cls) { return Alloc::MinSmallSize << cls; }
+
+    inline size_t sizeToClass(size_t size) {
+      size_t cls = 0;
+      while (classSize(cls) < size) cls++;
+      return cls;
+    }
+
+    struct FreeBlock { FreeBlock *Next; };
+
+    struct SharedList {
+      std::mutex Mutex{};
+      FreeBlock *Head = nullptr;
+    };
+
+    struct ThreadCache;
+
+    // Never destroyed: thread caches and other runtime singletons may outlive static destruction order.
+    struct Heap {
+      SharedList Lists[NumClasses]{};
+
+      std::mutex RegistryMutex{};
+      ThreadCache *Threads = nullptr;
+      size_t RetiredAllocs = 0, RetiredFrees = 0;
+      size_t RetiredBytesAlloc = 0, RetiredBytesFreed = 0;
+
+      std::atomic<size_t> Reserved{ 0 }, PeakReserved{ 0 };
+      std::atomic<AllocHooks*> Hooks{ nullptr };
+
+      void reserve(size_t bytes) {
+        size_t now = Reserved.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = PeakReserved.load(std::memory_order_relaxed);
+        while (now > peak && !PeakReserved.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+      }
+
+      void release(size_t bytes) { Reserved.fetch_sub(bytes, std::memory_order_relaxed); }
+    };
+
+    Heap &GetHeap() {
+      static Heap *heap = new Heap();
+      return *heap;
+    }
+
+    // Only the owning thread writes the counters, others read them in GetAllocStats().
+    inline void bump(std::atomic<size_t> &counter, size_t by) {
+      counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    struct ThreadCache {
+      FreeBlock *Heads[NumClasses]{};
+      size_t Counts[NumClasses]{};
+
+      std::atomic<size_t> Allocs{ 0 }, Frees{ 0 }, BytesAlloc{ 0 }, BytesFreed{ 0 };
+      ThreadCache *Prev = nullptr, *Next = nullptr;
+
+      ThreadCache() {
+        auto &heap = GetHeap();
+        std::lock_guard<std::mutex> lock(heap.RegistryMutex);
+        Next = heap.Threads;
+        if (Next) Next->Prev = this;
+        heap.Threads = this;
+      }
+
+      ~ThreadCache() {
+        Flush();
+
+        auto &heap = GetHeap();
+        std::lock_guard<std::mutex> lock(heap.RegistryMutex);
+        heap.RetiredAllocs += Allocs.load(std::memory_order_relaxed);
+        heap.RetiredFrees += Frees.load(std::memory_order_relaxed);
+        heap.RetiredBytesAlloc += BytesAlloc.load(std::memory_order_relaxed);
+        heap.RetiredBytesFreed += BytesFreed.load(std::memory_order_relaxed);
+        if (Prev) Prev->Next = Next;
+        else heap.Threads = Next;
+        if (Next) Next->Prev = Prev;
+      }
+
+      void Refill(size_t cls) {
+        auto &list = GetHeap().Lists[cls];
+        {
+          std::lock_guard<std::mutex> lock(list.Mutex);
+          while (list.Head && Counts[cls] < BatchSize) {
+            FreeBlock *block = list.Head;
+            list.Head = block->Next;
+            block->Next = Heads[cls];
+            Heads[cls] = block;
+            Counts[cls]++;
+          }
+        }
+        if (Counts[cls] > 0) return;
+
+        size_t stride = sizeof(BlockHeader) + classSize(cls);
+        size_t count = std::max(BatchSize, SlabSize / stride);
+        auto slab = (uint8_t*)std::malloc(stride * count);
+        if (!slab) return;
+        GetHeap().reserve(stride * count);
+
+        for (size_t i = count; i-- > 0;) {
+          auto header = (BlockHeader*)(slab + i * stride);
+          header->Class = (uint32_t)cls;
+          header->Size = classSize(cls);
+          auto block = (FreeBlock*)(header + 1);
+          block->Next = Heads[cls];
+          Heads[cls] = block;
+        }
+        Counts[cls] += count;
+      }
+
+      void Release(size_t cls, size_t keep) {
+        if (Counts[cls] <= keep) return;
+        FreeBlock *first = Heads[cls], *last = first;
+        size_t moved = 1;
+        while (Counts[cls] - moved > keep) { last = last->Next; moved++; }
+        Heads[cls] = last->Next;
+        Counts[cls] -= moved;
+
+        auto &list = GetHeap().Lists[cls];
+        std::lock_guard<std::mutex> lock(list.Mutex);
+        last->Next = list.Head;
+        list.Head = first;
+      }
+
+      void Flush() {
+        for (size_t cls = 0; cls < NumClasses; ++cls) Release(cls, 0);
+      }
+    };
+
+    ThreadCache &GetThreadCache() {
+      static thread_local ThreadCache cache{};
+      return cache;
+    }
+
+  }
+
+  namespace Alloc {
+
+    void *Allocate(size_t size) {
+      auto &heap = GetHeap();
+      auto &cache = GetThreadCache();
+      void *ptr = nullptr;
+      if (size > SIZE_MAX - sizeof(BlockHeader)) return nullptr;
+
+      if (size > MaxSmallSize) {
+        auto header = (BlockHeader*)std::malloc(sizeof(BlockHeader) + size);
+        if (!header) return nullptr;
+        header->Class = LargeClass;
+        header->Size = size;
+        heap.reserve(sizeof(BlockHeader) + size);
+        ptr = header + 1;
+      } else {
+        size_t cls = sizeToClass(size);
+        if (!cache.Heads[cls]) cache.Refill(cls);
+        FreeBlock *block = cache.Heads[cls];
+        if (!block) return nullptr;
+        cache.Heads[cls] = block->Next;
+        cache.Counts[cls]--;
+        size = classSize(cls);
+        ptr = block;
+      }
+
+      bump(cache.Allocs, 1);
+      bump(cache.BytesAlloc, size);
+      if (auto hooks = heap.Hooks.load(std::memory_order_acquire); hooks && hooks->OnAlloc)
+        hooks->OnAlloc(ptr, size, hooks->User);
+      return ptr;
+    }
+
+    void Deallocate(void *ptr) {
+      if (!ptr) return;
+      auto &heap = GetHeap();
+      auto &cache = GetThreadCache();
+      auto header = (BlockHeader*)ptr - 1;
+      size_t size = header->Size;
+
+      if (auto hooks = heap.Hooks.load(std::memory_order_acquire); hooks && hooks->OnFree)
+        hooks->OnFree(ptr, size, hooks->User);
+      bump(cache.Frees, 1);
+      bump(cache.BytesFreed, size);
+
+      if (header->Class == LargeClass) {
+        heap.release(sizeof(BlockHeader) + size);
+        std::free(header);
+        return;
+      }
+
+      size_t cls = header->Class;
+      auto block = (FreeBlock*)ptr;
+      block->Next = cache.Heads[cls];
+      cache.Heads[cls] = block;
+      if (++cache.Counts[cls] > 2 * BatchSize) cache.Release(cls, BatchSize);
+    }
+
+    void FlushThreadCache() {
+      GetThreadCache().Flush();
+    }
+
+  }
+
+  void SetAllocHooks(const AllocHooks &hooks) {
+    // Old hooks may still be running on other threads, so they are never freed
+    GetHeap().Hooks.store(new AllocHooks(hooks), std::memory_order_release);
+  }
+
+  AllocStats GetAllocStats() {
+    auto &heap = GetHeap();
+    std::lock_guard<std::mutex> lock(heap.RegistryMutex);
+    size_t allocs = heap.RetiredAllocs, frees = heap.RetiredFrees;
+    size_t bytesAlloc = heap.RetiredBytesAlloc, bytesFreed = heap.RetiredBytesFreed;
+    for (auto cache = heap.Threads; cache; cache = cache->Next) {
+      allocs += cache->Allocs.load(std::memory_order_relaxed);
+      frees += cache->Frees.load(std::memory_order_relaxed);
+      bytesAlloc += cache->BytesAlloc.load(std::memory_order_relaxed);
+      bytesFreed += cache->BytesFreed.load(std::memory_order_relaxed);
+    }
+
+    AllocStats stats{};
+    stats.Allocations = allocs;
+    stats.Frees = frees;
+    // Blocks can be freed by a different thread than the one that allocated them
+    stats.BytesInUse = bytesAlloc > bytesFreed ? bytesAlloc - bytesFreed : 0;
+    stats.PeakBytes = heap.PeakReserved.load(std::memory_order_relaxed);
+    return stats;
+  }
+  // =============== [ General Allocator ] ===============
+
+  FrameArena &GetFrameArena() {
+    static thread_local FrameArena arena{};
+    return arena;
+  }
+
+}
+
+// =============== [ Builtins ] ===============
+using namespace UraniumLang;
+
+extern "C" {
+
+  void *ulang_alloc(int64_t size) { return Alloc::Allocate(size > 0 ? (size_t)size : 0); }
+  void  ulang_free(void *ptr)     { Alloc::Deallocate(ptr); }
+
+  void *ulang_frame_alloc(int64_t size) { return GetFrameArena().Alloc(size > 0 ? (size_t)size : 0); }
+  void  ulang_frame_reset(void)         { GetFrameArena().Reset(); }
+
+  void *ulang_pool_create(int64_t objectSize) {
+    auto pool = new Pool(objectSize > 0 ? (size_t)objectSize : 1);
+    if (pool->IsValid()) return pool;
+    delete pool;
+    return nullptr;
+  }
+  void *ulang_pool_alloc(void *pool)            { return pool ? ((Pool*)pool)->Alloc() : nullptr; }
+  void  ulang_pool_free(void *pool, void *ptr)  { if (pool) ((Pool*)pool)->Free(ptr); }
+  void  ulang_pool_destroy(void *pool)          { delete (Pool*)pool; }
+
+  int64_t ulang_alloc_bytes_in_use(void) { return (int64_t)GetAllocStats().BytesInUse; }
+  int64_t ulang_alloc_peak_bytes(void)   { return (int64_t)GetAllocStats().PeakBytes; }
+
+}
+// =============== [ Builtins ] ===============
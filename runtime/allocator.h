@@ -0,0 +1,130 @@
+#ifndef ULANG_RUNTIME_ALLOCATOR_H
+#define ULANG_RUNTIME_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace UraniumLang {
+
+  // =============== [ Statistics ] ===============
+  // PeakBytes: high-water mark of BytesInUse for arenas and pools,
+  //            of memory reserved from the system for the general allocator.
+  struct AllocStats {
+    size_t Allocations = 0, Frees = 0;
+    size_t BytesInUse = 0, PeakBytes = 0;
+  };
+
+  // Called on every allocation/free made through the general allocator.
+  // Hooks must not allocate through ulang_alloc themselves.
+  struct AllocHooks {
+    void (*OnAlloc)(void *ptr, size_t size, void *user) = nullptr;
+    void (*OnFree)(void *ptr, size_t size, void *user) = nullptr;
+    void *User = nullptr;
+  };
+
+  void SetAllocHooks(const AllocHooks &hooks);
+  AllocStats GetAllocStats();
+  // =============== [ Statistics ] ===============
+
+  // =============== [ Frame Arena ] ===============
+  // Linear allocator, Reset() rewinds to the first block in O(1).
+  // Blocks grown past the initial capacity are kept and reused next frame.
+  class FrameArena {
+  public:
+    FrameArena(size_t capacity = 1 << 20);
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    void *Alloc(size_t size, size_t align = alignof(std::max_align_t));
+    void Reset();
+
+    inline size_t Used() const { return m_Used; }
+    inline size_t Capacity() const { return m_Capacity; }
+    inline AllocStats GetStats() const { return m_Stats; }
+  private:
+    struct Block {
+      uint8_t *Data;
+      size_t Size;
+    };
+
+    bool nextBlock(size_t minSize);
+  private:
+    std::vector<Block> m_Blocks{};
+    size_t m_Current = 0, m_Offset = 0;
+    size_t m_Used = 0, m_Capacity = 0;
+    AllocStats m_Stats{};
+  };
+  // =============== [ Frame Arena ] ===============
+
+  // =============== [ Object Pool ] ===============
+  // Fixed-size objects threaded through an intrusive free list.
+  class Pool {
+  public:
+    Pool(size_t objectSize, size_t objectsPerChunk = 64);
+    ~Pool();
+
+    Pool(const Pool &) = delete;
+    Pool &operator=(const Pool &) = delete;
+
+    void *Alloc();
+    void Free(void *ptr);
+
+    // False if objectSize * objectsPerChunk doesn't fit in size_t
+    inline bool IsValid() const { return m_ObjectSize != 0; }
+    inline size_t ObjectSize() const { return m_ObjectSize; }
+    inline AllocStats GetStats() const { return m_Stats; }
+  private:
+    void grow();
+  private:
+    struct FreeNode { FreeNode *Next; };
+
+    size_t m_ObjectSize = 0, m_ObjectsPerChunk = 0;
+    FreeNode *m_Free = nullptr;
+    std::vector<uint8_t*> m_Chunks{};
+    AllocStats m_Stats{};
+  };
+  // =============== [ Object Pool ] ===============
+
+  // =============== [ General Allocator ] ===============
+  // Size-classed allocator, each thread keeps a small cache per class and
+  // only touches the shared lists when its cache runs empty or overflows.
+  // Requests above MaxSmallSize go straight to malloc.
+  namespace Alloc {
+    constexpr size_t MinSmallSize = 16;
+    constexpr size_t MaxSmallSize = 4096;
+
+    void *Allocate(size_t size);
+    void Deallocate(void *ptr);
+
+    // Returns the calling thread's cached blocks to the shared lists
+    void FlushThreadCache();
+  }
+  // =============== [ General Allocator ] ===============
+
+  FrameArena &GetFrameArena(); // Per-thread arena used by ulang_frame_*
+
+}
+
+// =============== [ Builtins ] ===============
+extern "C" {
+  void *ulang_alloc(int64_t size);
+  void  ulang_free(void *ptr);
+
+  void *ulang_frame_alloc(int64_t size);
+  void  ulang_frame_reset(void);
+
+  void *ulang_pool_create(int64_t objectSize);
+  void *ulang_pool_alloc(void *pool);
+  void  ulang_pool_free(void *pool, void *ptr);
+  void  ulang_pool_destroy(void *pool);
+
+  int64_t ulang_alloc_bytes_in_use(void);
+  int64_t ulang_alloc_peak_bytes(void);
+}
+// =============== [ Builtins ] ===============
+
+#endif
@@ -0,0 +1,375 @@
+#include "jobs.h"
+
+#include "allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <new>
+
+namespace UraniumLang {
+
+  struct Job {
+    JobFunc Func = nullptr;
+    void *Arg = nullptr;
+    Job *Parent = nullptr;
+
+    std::atomic<int32_t> Unfinished{ 1 }; // Itself + unfinished children
+    std::atomic<int32_t> Blockers{ 1 };   // Unfinished dependencies + 1 until submitted
+    std::atomic<int32_t> Refs{ 2 };       // Creator + scheduler
+
+    std::mutex Mutex{};                   // Guards Finished and Dependents
+    bool Finished = false;
+    std::vector<Job*> Dependents{};
+
+    alignas(16) uint8_t Data[64];         // Payload of internal jobs (ParallelFor ranges)
+  };
+
+  namespace {
+
+    thread_local JobSystem *t_System = nullptr;
+    thread_local size_t t_Worker = 0;
+    thread_local uint32_t t_Seed = 0x9E3779B9u;
+
+    inline uint32_t nextRandom() {
+      uint32_t x = t_Seed;
+      x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+      return t_Seed = x;
+    }
+
+    struct RangeData {
+      JobSystem *System;
+      Job *Root;
+      RangeFunc Func;
+      void *Arg;
+      int64_t Begin, End, Grain;
+    };
+    static_assert(sizeof(RangeData) <= sizeof(Job::Data), "RangeData doesn't fit into Job::Data");
+
+  }
+
+  // =============== [ Work-Stealing Deque ] ===============
+  JobDeque::JobDeque(int64_t capacity) {
+    int64_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    m_Array.store(new Array{ cap, new std::atomic<Job*>[cap] }, std::memory_order_relaxed);
+  }
+
+  JobDeque::~JobDeque() {
+    m_Retired.push_back(m_Array.load(std::memory_order_relaxed));
+    for (auto array : m_Retired) {
+      delete[] array->Items;
+      delete array;
+    }
+  }
+
+  void JobDeque::Push(Job *job) {
+    int64_t b = m_Bottom.load(std::memory_order_relaxed);
+    int64_t t = m_Top.load(std::memory_order_acquire);
+    Array *array = m_Array.load(std::memory_order_relaxed);
+    if (b - t > array->Capacity - 1) array = grow(array, t, b);
+    array->Put(b, job);
+    m_Bottom.store(b + 1, std::memory_order_release);
+  }
+
+  Job *JobDeque::Pop() {
+    int64_t b = m_Bottom.load(std::memory_order_relaxed) - 1;
+    Array *array = m_Array.load(std::memory_order_relaxed);
+    m_Bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = m_Top.load(std::memory_order_seq_cst);
+
+    if (t > b) { // Empty
+      m_Bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Job *job = array->Get(b);
+    if (t == b) { // Last job, race against thieves
+      if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+      m_Bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+  }
+
+  Job *JobDeque::Steal() {
+    int64_t t = m_Top.load(std::memory_order_seq_cst);
+    int64_t b = m_Bottom.load(std::memory_order_seq_cst);
+    if (t >= b) return nullptr;
+
+    Array *array = m_Array.load(std::memory_order_acquire);
+    Job *job = array->Get(t);
+    if (!m_Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return job;
+  }
+
+  int64_t JobDeque::Size() const {
+    int64_t b = m_Bottom.load(std::memory_order_relaxed);
+    int64_t t = m_Top.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+
+  // private:
+
+  JobDeque::Array *JobDeque::grow(Array *array, int64_t top, int64_t bottom) {
+    auto bigger = new Array{ array->Capacity * 2, new std::atomic<Job*>[array->Capacity * 2] };
+    for (int64_t i = top; i < bottom; ++i) bigger->Put(i, array->Get(i));
+    m_Retired.push_back(array);
+    m_Array.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+  // =============== [ Work-Stealing Deque ] ===============
+
+  // =============== [ Job System ] ===============
+  JobSystem::JobSystem(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 1; i < threads; ++i) m_Deques.push_back(new JobDeque());
+    for (size_t i = 0; i < m_Deques.size(); ++i) m_Workers.emplace_back(&JobSystem::workerLoop, this, i);
+  }
+
+  JobSystem::~JobSystem() {
+    m_Shutdown.store(true, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(m_SleepMutex);
+    }
+    m_WakeCv.notify_all();
+    for (auto &worker : m_Workers) worker.join();
+    for (auto deque : m_Deques) delete deque;
+  }
+
+  Job *JobSystem::Create(JobFunc func, void *arg, Job *parent) {
+    auto job = new (Alloc::Allocate(sizeof(Job))) Job();
+    job->Func = func;
+    job->Arg = arg;
+    job->Parent = parent;
+    if (parent) parent->Unfinished.fetch_add(1, std::memory_order_relaxed);
+    return job;
+  }
+
+  void JobSystem::DependsOn(Job *job, Job *dependency) {
+    std::lock_guard<std::mutex> lock(dependency->Mutex);
+    if (dependency->Finished) return;
+    job->Blockers.fetch_add(1, std::memory_order_relaxed);
+    dependency->Dependents.push_back(job);
+  }
+
+  void JobSystem::Submit(Job *job) {
+    if (job->Blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) enqueue(job);
+  }
+
+  void JobSystem::Wait(Job *job) {
+    while (job->Unfinished.load(std::memory_order_acquire) > 0) {
+      if (Job *next = findJob()) execute(next);
+      else std::this_thread::yield();
+    }
+  }
+
+  void JobSystem::Release(Job *job) {
+    if (job->Refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    job->~Job();
+    Alloc::Deallocate(job);
+  }
+
+  void JobSystem::ParallelFor(int64_t begin, int64_t end, RangeFunc func, void *arg, int64_t grain) {
+    if (begin >= end) return;
+    if (grain <= 0) grain = std::clamp<int64_t>((end - begin) / (int64_t)(ThreadCount() * 32), 1, 4096);
+
+    // The root covers every chunk, the calling thread starts on the whole range
+    Job *root = Create(nullptr, nullptr);
+    RangeData range{ this, root, func, arg, begin, end, grain };
+    runRange(&range);
+    finish(root);
+    Wait(root);
+    Release(root);
+  }
+
+  // private:
+
+  void JobSystem::runRange(void *arg) {
+    auto &range = *(RangeData*)arg;
+    auto self = range.System;
+    int64_t begin = range.Begin, end = range.End;
+
+    // Lazy binary splitting: hand out the upper half only once our queue has been drained by thieves
+    while (begin < end) {
+      if (end - begin > range.Grain && self->shouldSplit()) {
+        int64_t mid = begin + (end - begin) / 2;
+        Job *child = self->Create(&JobSystem::runRange, nullptr, range.Root);
+        auto data = new (child->Data) RangeData(range);
+        data->Begin = mid;
+        data->End = end;
+        child->Arg = data;
+        self->Submit(child);
+        self->Release(child);
+        end = mid;
+        continue;
+      }
+
+      int64_t stop = std::min(end, begin + range.Grain);
+      range.Func(begin, stop, range.Arg);
+      begin = stop;
+    }
+  }
+
+  bool JobSystem::shouldSplit() {
+    if (m_Workers.empty()) return false;
+    if (auto deque = localDeque()) return deque->Size() == 0;
+    return m_InjectedCount.load(std::memory_order_relaxed) == 0;
+  }
+
+  void JobSystem::workerLoop(size_t index) {
+    t_System = this;
+    t_Worker = index;
+    t_Seed ^= (uint32_t)(index + 1) * 0x85EBCA6Bu;
+
+    size_t spins = 0;
+    while (!m_Shutdown.load(std::memory_order_acquire)) {
+      if (Job *job = findJob()) {
+        execute(job);
+        spins = 0;
+      }
+      else idle(spins);
+    }
+  }
+
+  void JobSystem::execute(Job *job) {
+    job->Func(job->Arg);
+    finish(job);
+  }
+
+  void JobSystem::finish(Job *job) {
+    if (job->Unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    std::vector<Job*> dependents{};
+    {
+      std::lock_guard<std::mutex> lock(job->Mutex);
+      job->Finished = true;
+      dependents.swap(job->Dependents);
+    }
+    for (auto dependent : dependents) Submit(dependent);
+
+    if (job->Parent) finish(job->Parent);
+    Release(job);
+  }
+
+  void JobSystem::enqueue(Job *job) {
+    if (auto deque = localDeque()) deque->Push(job);
+    else {
+      std::lock_guard<std::mutex> lock(m_InjectMutex);
+      m_Injected.push_back(job);
+      m_InjectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Pairs with idle(): the read-modify-write orders us against a worker going to sleep,
+    // so either it sees the new job or we see it sleeping
+    if (m_Sleepers.fetch_add(0, std::memory_order_seq_cst) > 0) {
+      {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+      }
+      m_WakeCv.notify_one();
+    }
+  }
+
+  Job *JobSystem::findJob() {
+    JobDeque *local = localDeque();
+    if (local) {
+      if (Job *job = local->Pop()) return job;
+    }
+
+    if (m_InjectedCount.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(m_InjectMutex);
+      if (!m_Injected.empty()) {
+        Job *job = m_Injected.front();
+        m_Injected.pop_front();
+        m_InjectedCount.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+
+    size_t count = m_Deques.size();
+    if (count == 0) return nullptr;
+    size_t start = nextRandom() % count;
+    for (size_t i = 0; i < count; ++i) {
+      JobDeque *victim = m_Deques[(start + i) % count];
+      if (victim == local) continue;
+      if (Job *job = victim->Steal()) return job;
+    }
+    return nullptr;
+  }
+
+  bool JobSystem::hasWork() {
+    if (m_InjectedCount.load(std::memory_order_seq_cst) > 0) return true;
+    for (auto deque : m_Deques) if (deque->Size() > 0) return true;
+    return false;
+  }
+
+  void JobSystem::idle(size_t &spins) {
+    if (++spins < 64) {
+      std::this_thread::yield();
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_SleepMutex);
+    m_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+    if (!hasWork() && !m_Shutdown.load(std::memory_order_acquire))
+      m_WakeCv.wait_for(lock, std::chrono::milliseconds(10));
+    m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  JobDeque *JobSystem::localDeque() {
+    return t_System == this ? m_Deques[t_Worker] : nullptr;
+  }
+  // =============== [ Job System ] ===============
+
+  namespace {
+
+    std::mutex g_SystemMutex{};
+    std::atomic<JobSystem*> g_System{ nullptr };
+    std::unique_ptr<JobSystem> g_SystemOwner{}; // Joins the workers at exit
+    size_t g_SystemThreads = 0;
+
+  }
+
+  JobSystem &GetJobSystem() {
+    if (auto system = g_System.load(std::memory_order_acquire)) return *system;
+
+    std::lock_guard<std::mutex> lock(g_SystemMutex);
+    if (!g_SystemOwner) {
+      g_SystemOwner = std::make_unique<JobSystem>(g_SystemThreads);
+      g_System.store(g_SystemOwner.get(), std::memory_order_release);
+    }
+    return *g_SystemOwner;
+  }
+
+}
+
+// =============== [ Builtins ] ===============
+using namespace UraniumLang;
+
+extern "C" {
+
+  void ulang_jobs_init(int64_t threads) {
+    std::lock_guard<std::mutex> lock(g_SystemMutex);
+    if (!g_SystemOwner) g_SystemThreads = threads > 0 ? (size_t)threads : 0;
+  }
+
+  void *ulang_spawn(void (*func)(void *arg), void *arg) {
+    auto &system = GetJobSystem();
+    Job *job = system.Create(func, arg);
+    system.Submit(job);
+    return job;
+  }
+
+  void ulang_join(void *handle) {
+    if (!handle) return;
+    auto &system = GetJobSystem();
+    system.Wait((Job*)handle);
+    system.Release((Job*)handle);
+  }
+
+  void ulang_parallel_for(int64_t begin, int64_t end, void (*func)(int64_t begin, int64_t end, void *arg), void *arg) {
+    GetJobSystem().ParallelFor(begin, end, func, arg);
+  }
+
+}
+// =============== [ Builtins ] ===============
@@ -0,0 +1,123 @@
+#ifndef ULANG_RUNTIME_JOBS_H
+#define ULANG_RUNTIME_JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UraniumLang {
+
+  using JobFunc = void (*)(void *arg);
+  using RangeFunc = void (*)(int64_t begin, int64_t end, void *arg);
+
+  struct Job;
+
+  // =============== [ Work-Stealing Deque ] ===============
+  // Chase-Lev deque, the owning worker pushes and pops at the bottom,
+  // every other thread steals from the top.
+  class JobDeque {
+  public:
+    JobDeque(int64_t capacity = 256);
+    ~JobDeque();
+
+    JobDeque(const JobDeque &) = delete;
+    JobDeque &operator=(const JobDeque &) = delete;
+
+    void Push(Job *job); // Owner only
+    Job *Pop();          // Owner only
+    Job *Steal();        // Any thread
+
+    int64_t Size() const;
+  private:
+    struct Array {
+      int64_t Capacity;
+      std::atomic<Job*> *Items;
+
+      inline Job *Get(int64_t i) { return Items[i & (Capacity - 1)].load(std::memory_order_relaxed); }
+      inline void Put(int64_t i, Job *job) { Items[i & (Capacity - 1)].store(job, std::memory_order_relaxed); }
+    };
+
+    Array *grow(Array *array, int64_t top, int64_t bottom);
+  private:
+    std::atomic<int64_t> m_Top{ 0 }, m_Bottom{ 0 };
+    std::atomic<Array*> m_Array{ nullptr };
+    std::vector<Array*> m_Retired{}; // Thieves may still be reading them, freed with the deque
+  };
+  // =============== [ Work-Stealing Deque ] ===============
+
+  // =============== [ Job System ] ===============
+  class JobSystem {
+  public:
+    // threads: Number of threads running jobs, including the one calling Wait().
+    //          0 = one per hardware thread
+    JobSystem(size_t threads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Every created job has to be submitted, the caller owns one reference until Release()
+    Job *Create(JobFunc func, void *arg, Job *parent = nullptr);
+    // job won't start before dependency has finished, call before submitting job
+    void DependsOn(Job *job, Job *dependency);
+    void Submit(Job *job);
+    // Runs other jobs until job and all of its children have finished
+    void Wait(Job *job);
+    void Release(Job *job);
+
+    // Calls func on chunks of [begin, end), splitting further only while other threads are idle.
+    // grain: smallest chunk, 0 = picked from the range and thread count
+    void ParallelFor(int64_t begin, int64_t end, RangeFunc func, void *arg, int64_t grain = 0);
+
+    inline size_t ThreadCount() const { return m_Workers.size() + 1; }
+  private:
+    static void runRange(void *arg);
+    bool shouldSplit();
+
+    void workerLoop(size_t index);
+    void execute(Job *job);
+    void finish(Job *job);
+    void enqueue(Job *job);
+    Job *findJob();
+    bool hasWork();
+    void idle(size_t &spins);
+    JobDeque *localDeque();
+  private:
+    std::vector<std::thread> m_Workers{};
+    std::vector<JobDeque*> m_Deques{}; // One per worker
+
+    // Jobs submitted from threads outside the pool
+    std::mutex m_InjectMutex{};
+    std::deque<Job*> m_Injected{};
+    std::atomic<size_t> m_InjectedCount{ 0 };
+
+    std::mutex m_SleepMutex{};
+    std::condition_variable m_WakeCv{};
+    std::atomic<size_t> m_Sleepers{ 0 };
+    std::atomic<bool> m_Shutdown{ false };
+  };
+  // =============== [ Job System ] ===============
+
+  // Shared job system used by the ulang_* builtins, created on first use
+  JobSystem &GetJobSystem();
+
+}
+
+// =============== [ Builtins ] ===============
+extern "C" {
+  // Has to be called before any other job builtin to take effect
+  void  ulang_jobs_init(int64_t threads);
+
+  // Every handle returned by ulang_spawn has to be joined exactly once
+  void *ulang_spawn(void (*func)(void *arg), void *arg);
+  void  ulang_join(void *handle);
+
+  void  ulang_parallel_for(int64_t begin, int64_t end, void (*func)(int64_t begin, int64_t end, void *arg), void *arg);
+}
+// =============== [ Builtins ] ===============
+
+#endif
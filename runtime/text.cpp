@@ -0,0 +1,39 @@
+#include "text.h"
+
+#include <cstdio>
+#include <string>
+
+extern "C" {
+
+  void ulang_print_num(double value) {
+    std::printf("%.17g\n", value);
+  }
+
+  void *ulang_str_new(void) {
+    return new std::string();
+  }
+
+  void ulang_str_append(void *str, const char *text) {
+    if (str && text) ((std::string*)str)->append(text);
+  }
+
+  void ulang_str_append_num(void *str, double value) {
+    if (!str) return;
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    ((std::string*)str)->append(buffer, length);
+  }
+
+  int64_t ulang_str_length(void *str) {
+    return str ? (int64_t)((std::string*)str)->size() : 0;
+  }
+
+  void ulang_str_print(void *str) {
+    if (str) std::printf("%s\n", ((std::string*)str)->c_str());
+  }
+
+  void ulang_str_free(void *str) {
+    delete (std::string*)str;
+  }
+
+}
@@ -0,0 +1,20 @@
+#ifndef ULANG_RUNTIME_TEXT_H
+#define ULANG_RUNTIME_TEXT_H
+
+#include <cstdint>
+
+// =============== [ Builtins ] ===============
+extern "C" {
+  void ulang_print_num(double value);
+
+  // Growable string, handles are owned by the caller until ulang_str_free
+  void   *ulang_str_new(void);
+  void    ulang_str_append(void *str, const char *text);
+  void    ulang_str_append_num(void *str, double value);
+  int64_t ulang_str_length(void *str);
+  void    ulang_str_print(void *str);
+  void    ulang_str_free(void *str);
+}
+// =============== [ Builtins ] ===============
+
+#endif
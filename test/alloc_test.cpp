@@ -0,0 +1,103 @@
+// Tests for the frame arena, the object pool and the general allocator.
+// Usage: ulang_alloc_test
+#include <allocator.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+using namespace UraniumLang;
+
+namespace {
+
+  int g_Failures = 0;
+
+  void check(bool condition, const char *test, const char *what) {
+    if (condition) return;
+    std::printf("  FAILED %s: %s\n", test, what);
+    g_Failures++;
+  }
+
+  bool aligned(void *ptr, size_t align) { return ((uintptr_t)ptr & (align - 1)) == 0; }
+
+  void testArena() {
+    FrameArena arena(64);
+    void *a = arena.Alloc(24), *b = arena.Alloc(24);
+    check(a && b && a != b, "arena", "two small allocations");
+    check(aligned(a, alignof(std::max_align_t)) && aligned(b, alignof(std::max_align_t)), "arena", "default alignment");
+
+    void *big = arena.Alloc(1000, 64);
+    check(big && aligned(big, 64), "arena", "allocation larger than the block grows the arena");
+    std::memset(big, 0xab, 1000);
+    check(arena.Capacity() >= 64 + 1000, "arena", "capacity includes the new block");
+
+    arena.Reset();
+    check(arena.Used() == 0 && arena.Alloc(16) == a, "arena", "reset rewinds to the first block");
+    check(arena.Alloc(8, 3) == nullptr, "arena", "non power of two alignment is rejected");
+  }
+
+  // Sizes that would wrap the bounds and block size computations
+  void testArenaOverflow() {
+    FrameArena arena(64);
+    arena.Alloc(8);
+    check(arena.Alloc(SIZE_MAX - 15) == nullptr, "arena overflow", "SIZE_MAX - 15");
+    check(arena.Alloc(SIZE_MAX) == nullptr, "arena overflow", "SIZE_MAX");
+    check(arena.Alloc(SIZE_MAX - 8, 16) == nullptr, "arena overflow", "size + align wraps");
+    check(arena.Alloc(8) != nullptr, "arena overflow", "arena still usable afterwards");
+  }
+
+  void testPool() {
+    Pool pool(24, 4);
+    check(pool.IsValid() && pool.ObjectSize() >= 24, "pool", "valid pool");
+    void *objects[10];
+    for (auto &object : objects) object = pool.Alloc();
+    bool distinct = true;
+    for (size_t i = 0; i < 10; ++i)
+      for (size_t j = i + 1; j < 10; ++j) distinct = distinct && objects[i] && objects[i] != objects[j];
+    check(distinct, "pool", "allocations over several chunks are distinct");
+
+    pool.Free(objects[3]);
+    check(pool.Alloc() == objects[3], "pool", "freed object is reused first");
+    check(pool.GetStats().BytesInUse == 10 * pool.ObjectSize(), "pool", "bytes in use");
+  }
+
+  void testPoolOverflow() {
+    Pool pool(SIZE_MAX / 32, 64);
+    check(!pool.IsValid() && pool.Alloc() == nullptr, "pool overflow", "chunk size wraps");
+    Pool huge(SIZE_MAX, 1);
+    check(!huge.IsValid() && huge.Alloc() == nullptr, "pool overflow", "object size wraps when aligned");
+
+    // 2^58 * 64 objects per chunk wraps to 0
+    void *created = ulang_pool_create(288230376151711744);
+    check(created == nullptr && ulang_pool_alloc(created) == nullptr, "pool overflow", "ulang_pool_create rejects the size");
+  }
+
+  void testGeneral() {
+    for (size_t size : { 1, 16, 17, 100, 4096, 4097, 100000 }) {
+      auto ptr = (uint8_t*)Alloc::Allocate(size);
+      check(ptr && aligned(ptr, 16), "general", "allocation is aligned");
+      if (!ptr) continue;
+      std::memset(ptr, 0xcd, size);
+      Alloc::Deallocate(ptr);
+    }
+    Alloc::FlushThreadCache();
+  }
+
+  void testGeneralOverflow() {
+    check(Alloc::Allocate(SIZE_MAX - 7) == nullptr, "general overflow", "SIZE_MAX - 7");
+    check(Alloc::Allocate(SIZE_MAX) == nullptr, "general overflow", "SIZE_MAX");
+  }
+
+}
+
+int main() {
+  testArena();
+  testArenaOverflow();
+  testPool();
+  testPoolOverflow();
+  testGeneral();
+  testGeneralOverflow();
+
+  std::printf("%s\n", g_Failures ? "alloc tests failed" : "alloc tests passed");
+  return g_Failures ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+// Tests for the binary AST format: round trips and rejection of damaged buffers.
+// Usage: ulang_astfile_test
+#include <astfile.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace UraniumLang;
+
+namespace {
+
+  int g_Failures = 0;
+
+  void check(bool condition, const char *test, const char *what) {
+    if (condition) return;
+    std::printf("  FAILED %s: %s\n", test, what);
+    g_Failures++;
+  }
+
+  // Uses every node kind, every operator and both values of each flag
+  constexpr const char *Source =
+    "soa struct P { double x; double y; };\n"
+    "struct Q { double z; };\n"
+    "P ps[8];\n"
+    "double a = 1 + 2 - 3 * 4 / 5;\n"
+    "str_print(\"hi\");\n"
+    "a = ps[2].x;\n"
+    "double h = spawn { a = 1; };\n"
+    "join h;\n"
+    "{ double b; }\n"
+    "parallel_for (i = 0 : 8) { ps[i].y = i; }\n"
+    "for (j = 0 : 2) { }\n";
+
+  constexpr const char *Expected =
+    "(Prog"
+    " (StructDecl:1 \"P\" (Field \"x\" \"double\") (Field \"y\" \"double\"))"
+    " (StructDecl \"Q\" (Field \"z\" \"double\"))"
+    " (ArrayDecl \"ps\" \"P\" (NumLit \"8\"))"
+    " (VarDecl \"a\" \"double\" (Bin:1 (Bin:0 (NumLit \"1\") (NumLit \"2\")) (Bin:3 (Bin:2 (NumLit \"3\") (NumLit \"4\")) (NumLit \"5\"))))"
+    " (Call \"str_print\" (StrLit \"hi\"))"
+    " (Assignment (Ident \"a\") (Member \"x\" (Index (Ident \"ps\") (NumLit \"2\"))))"
+    " (VarDecl \"h\" \"double\" (Spawn (Scope (Assignment (Ident \"a\") (NumLit \"1\")))))"
+    " (Join (Ident \"h\"))"
+    " (Scope (VarDecl \"b\" \"double\" _))"
+    " (For:1 \"i\" (NumLit \"0\") (NumLit \"8\") (Scope (Assignment (Member \"y\" (Index (Ident \"ps\") (Ident \"i\"))) (Ident \"i\"))))"
+    " (For \"j\" (NumLit \"0\") (NumLit \"2\") (Scope)))";
+
+  const char *kindName(ASTNodeKind kind) {
+    static const char *names[] = {
+      "Prog", "Ident", "NumLit", "StrLit", "Bin", "Assignment", "Call", "Spawn", "Index",
+      "Member", "VarDecl", "ArrayDecl", "StructDecl", "Field", "Scope", "Join", "For"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == (size_t)ASTNodeKind::Count, "Every kind needs a name");
+    return names[(size_t)kind];
+  }
+
+  // "(Kind[:flags] "string"... child...)", "_" for a missing child
+  void dump(ASTNode node, std::string &out, std::vector<bool> &seen) {
+    if (!node) {
+      out += "_";
+      return;
+    }
+    seen[(size_t)node.GetKind()] = true;
+    out += "(";
+    out += kindName(node.GetKind());
+    if (node.GetFlags() || node.GetKind() == ASTNodeKind::Bin) out += ":" + std::to_string(node.GetFlags());
+    for (size_t i = 0; i < node.GetStringCount(); ++i) out += " \"" + std::string(node.GetString(i)) + "\"";
+    for (size_t i = 0; i < node.GetChildCount(); ++i) {
+      out += " ";
+      dump(node.GetChild(i), out, seen);
+    }
+    out += ")";
+  }
+
+  std::vector<uint8_t> serialize(const char *source) {
+    Parser parser(std::make_unique<Lexer>(std::make_unique<std::istringstream>(source)));
+    auto prog = parser.Parse();
+    check(parser.GetDiagnostics().empty(), "serialize", "source parses without diagnostics");
+    return SerializeAST(prog.get());
+  }
+
+  ASTFileHeader readHeader(const std::vector<uint8_t> &data) {
+    ASTFileHeader header{};
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header;
+  }
+
+  // Stores header and recomputes the checksum, so damage behind it reaches the structural checks
+  void writeHeader(std::vector<uint8_t> &data, ASTFileHeader header) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = sizeof(header); i < data.size(); ++i) hash = (hash ^ data[i]) * 16777619u;
+    header.Checksum = hash;
+    std::memcpy(data.data(), &header, sizeof(header));
+  }
+
+  uint32_t readU32(const std::vector<uint8_t> &data, size_t offset) {
+    uint32_t value = 0;
+    std::memcpy(&value, &data[offset], sizeof(value));
+    return value;
+  }
+
+  void writeU32(std::vector<uint8_t> &data, size_t offset, uint32_t value) {
+    std::memcpy(&data[offset], &value, sizeof(value));
+  }
+
+  bool opens(const std::vector<uint8_t> &data, size_t size) {
+    ASTView view{};
+    return view.Open(data.data(), size);
+  }
+
+  bool opens(const std::vector<uint8_t> &data) { return opens(data, data.size()); }
+
+  void testRoundTrip() {
+    auto data = serialize(Source);
+    ASTView view{};
+    std::string error{};
+    check(!data.empty() && view.Open(data.data(), data.size(), &error), "round trip", "serialized buffer opens");
+    if (!view.IsOpen()) return;
+
+    std::string text{};
+    std::vector<bool> seen((size_t)ASTNodeKind::Count, false);
+    dump(view.GetRoot(), text, seen);
+    check(text == Expected, "round trip", "tree reads back as written");
+    if (text != Expected) std::printf("    got: %s\n", text.c_str());
+
+    bool all = true;
+    for (bool kind : seen) all = all && kind;
+    check(all, "round trip", "every node kind is covered");
+
+    check(serialize(Source) == data, "round trip", "serializing is deterministic");
+  }
+
+  void testFile() {
+    Parser parser(std::make_unique<Lexer>(std::make_unique<std::istringstream>(Source)));
+    auto prog = parser.Parse();
+    std::string path = "ulang_astfile_test.uast";
+    check(WriteAST(prog.get(), path), "file", "WriteAST succeeds");
+
+    {
+      ASTFile file(path);
+      std::string text{};
+      std::vector<bool> seen((size_t)ASTNodeKind::Count, false);
+      if (file.IsValid()) dump(file.GetRoot(), text, seen);
+      check(file.IsValid() && text == Expected, "file", "mapped file reads back as written");
+    }
+    std::remove(path.c_str());
+
+    ASTFile missing("ulang_astfile_test_missing.uast");
+    check(!missing.IsValid() && !missing.GetError().empty(), "file", "missing file is reported");
+  }
+
+  void testHeader() {
+    auto data = serialize(Source);
+    auto header = readHeader(data);
+
+    auto damaged = data;
+    damaged[0] = 'X';
+    check(!opens(damaged), "header", "wrong magic is rejected");
+
+    auto version = header;
+    version.Version = ASTVersion + 1;
+    damaged = data;
+    writeHeader(damaged, version);
+    check(!opens(damaged), "header", "newer version is rejected");
+    version.Version = ASTVersion - 1;
+    writeHeader(damaged, version);
+    check(!opens(damaged), "header", "older version is rejected");
+
+    auto order = header;
+    order.ByteOrder = 0x0201;
+    damaged = data;
+    writeHeader(damaged, order);
+    check(!opens(damaged), "header", "other byte order is rejected");
+
+    auto sections = header;
+    sections.StringCount += 1000;
+    damaged = data;
+    writeHeader(damaged, sections);
+    check(!opens(damaged), "header", "string table past the end is rejected");
+  }
+
+  void testTruncated() {
+    auto data = serialize(Source);
+    bool rejected = true;
+    for (size_t size = 0; size < data.size(); size += 4) rejected = rejected && !opens(data, size);
+    check(rejected, "truncated", "every shorter prefix is rejected");
+
+    auto header = readHeader(data);
+    auto shorter = std::vector<uint8_t>(data.begin(), data.end() - 4);
+    header.Size = shorter.size();
+    writeHeader(shorter, header);
+    check(!opens(shorter), "truncated", "shortened buffer with a matching header is rejected");
+  }
+
+  void testCorrupted() {
+    auto data = serialize(Source);
+
+    // Damage without a new checksum
+    bool rejected = true;
+    for (size_t i = sizeof(ASTFileHeader); i < data.size(); ++i) {
+      auto damaged = data;
+      damaged[i] ^= 0x40;
+      rejected = rejected && !opens(damaged);
+    }
+    check(rejected, "corrupted", "every flipped byte fails the checksum");
+
+    // Damage with a new checksum has to be caught by the structure checks or read safely
+    for (size_t i = sizeof(ASTFileHeader); i < data.size(); ++i) {
+      for (uint8_t bit : { 0x01, 0x10, 0x80 }) {
+        auto damaged = data;
+        damaged[i] ^= bit;
+        writeHeader(damaged, readHeader(damaged));
+        ASTView view{};
+        if (!view.Open(damaged.data(), damaged.size())) continue;
+        std::string text{};
+        std::vector<bool> seen((size_t)ASTNodeKind::Count, false);
+        dump(view.GetRoot(), text, seen);
+      }
+    }
+  }
+
+  void testNodes() {
+    auto data = serialize(Source);
+    auto header = readHeader(data);
+    uint32_t root = header.Root;
+    size_t firstChild = root + sizeof(ASTNodeHeader);
+    uint32_t child = readU32(data, firstChild);
+
+    auto damaged = data;
+    writeU32(damaged, firstChild, root);
+    writeHeader(damaged, header);
+    check(!opens(damaged), "nodes", "child offset equal to its parent is rejected");
+
+    // Turn the first string of the first node (a leaf) into a child pointing at the root written after it
+    damaged = data;
+    ASTNodeHeader first{};
+    std::memcpy(&first, &damaged[header.NodesOffset], sizeof(first));
+    check(first.ChildCount == 0 && first.StringCount > 0, "nodes", "first node is a leaf with strings");
+    first.ChildCount = 1;
+    first.StringCount--;
+    std::memcpy(&damaged[header.NodesOffset], &first, sizeof(first));
+    writeU32(damaged, header.NodesOffset + sizeof(first), root);
+    writeHeader(damaged, header);
+    check(!opens(damaged), "nodes", "child offset after its parent is rejected");
+
+    damaged = data;
+    writeU32(damaged, firstChild, child + 4);
+    writeHeader(damaged, header);
+    check(!opens(damaged), "nodes", "child offset inside another node is rejected");
+
+    damaged = data;
+    writeU32(damaged, firstChild, child + 2);
+    writeHeader(damaged, header);
+    check(!opens(damaged), "nodes", "unaligned child offset is rejected");
+
+    ASTNodeHeader rootNode{};
+    std::memcpy(&rootNode, &data[root], sizeof(rootNode));
+    damaged = data;
+    rootNode.Kind = (uint16_t)ASTNodeKind::Count;
+    std::memcpy(&damaged[root], &rootNode, sizeof(rootNode));
+    writeHeader(damaged, header);
+    check(!opens(damaged), "nodes", "unknown node kind is rejected");
+
+    auto badRoot = header;
+    badRoot.Root = child;
+    damaged = data;
+    writeHeader(damaged, badRoot);
+    check(!opens(damaged), "nodes", "root that isn't a Prog node is rejected");
+  }
+
+  // Finds the first node of kind, 0 if there is none
+  size_t findNode(const std::vector<uint8_t> &data, ASTNodeKind kind) {
+    auto header = readHeader(data);
+    for (size_t pos = header.NodesOffset; pos < header.NodesOffset + header.NodesSize;) {
+      ASTNodeHeader node{};
+      std::memcpy(&node, &data[pos], sizeof(node));
+      if (node.Kind == (uint16_t)kind) return pos;
+      pos += sizeof(node) + (node.ChildCount + node.StringCount) * sizeof(uint32_t);
+    }
+    return 0;
+  }
+
+  void testValues() {
+    auto data = serialize(Source);
+    auto header = readHeader(data);
+
+    size_t bin = findNode(data, ASTNodeKind::Bin);
+    check(bin != 0, "values", "program has a Bin node");
+    if (bin) {
+      auto damaged = data;
+      ASTNodeHeader node{};
+      std::memcpy(&node, &damaged[bin], sizeof(node));
+      node.Flags = (uint16_t)ASTBinOp::Count;
+      std::memcpy(&damaged[bin], &node, sizeof(node));
+      writeHeader(damaged, header);
+      check(!opens(damaged), "values", "unknown operator is rejected");
+    }
+
+    size_t ident = findNode(data, ASTNodeKind::Ident);
+    check(ident != 0, "values", "program has an Ident node");
+    if (ident) {
+      auto damaged = data;
+      writeU32(damaged, ident + sizeof(ASTNodeHeader), header.StringCount);
+      writeHeader(damaged, header);
+      check(!opens(damaged), "values", "string index out of range is rejected");
+
+      damaged = data;
+      size_t table = header.StringsOffset + readU32(data, ident + sizeof(ASTNodeHeader)) * sizeof(ASTString);
+      writeU32(damaged, table + 4, (uint32_t)data.size());
+      writeHeader(damaged, header);
+      check(!opens(damaged), "values", "string past the end is rejected");
+    }
+  }
+
+}
+
+int main() {
+  testRoundTrip();
+  testFile();
+  testHeader();
+  testTruncated();
+  testCorrupted();
+  testNodes();
+  testValues();
+
+  std::printf("%s\n", g_Failures ? "astfile tests failed" : "astfile tests passed");
+  return g_Failures ? 1 : 0;
+}
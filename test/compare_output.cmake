@@ -0,0 +1,15 @@
+# Runs two programs and fails unless both succeed and print the same
+# Usage: cmake -DFIRST=<exe> -DSECOND=<exe> -P compare_output.cmake
+foreach(exe FIRST SECOND)
+  execute_process(COMMAND ${${exe}} OUTPUT_VARIABLE ${exe}_OUTPUT RESULT_VARIABLE ${exe}_RESULT)
+  if(NOT ${exe}_RESULT EQUAL 0)
+    message(FATAL_ERROR "${${exe}} failed: ${${exe}_RESULT}")
+  endif()
+endforeach()
+
+if(FIRST_OUTPUT STREQUAL "")
+  message(FATAL_ERROR "${FIRST} printed nothing")
+endif()
+if(NOT FIRST_OUTPUT STREQUAL SECOND_OUTPUT)
+  message(FATAL_ERROR "Outputs differ\n${FIRST}:\n${FIRST_OUTPUT}\n${SECOND}:\n${SECOND_OUTPUT}")
+endif()
@@ -0,0 +1,225 @@
+// Tests for the work-stealing deque and the job system.
+// Build with -DULANG_TSAN=ON to run them under ThreadSanitizer.
+// Usage: ulang_jobs_test [threads]
+#include <jobs.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace UraniumLang;
+
+namespace {
+
+  int g_Failures = 0;
+
+  void check(bool condition, const char *test, const char *what) {
+    if (condition) return;
+    std::printf("  FAILED %s: %s\n", test, what);
+    g_Failures++;
+  }
+
+  // The deque never looks at jobs, addresses inside an array tell them apart
+  Job *fakeJob(std::vector<char> &items, size_t i) { return reinterpret_cast<Job*>(&items[i]); }
+  size_t fakeIndex(std::vector<char> &items, Job *job) { return reinterpret_cast<char*>(job) - items.data(); }
+
+  void testDequeOrder() {
+    std::vector<char> items(100);
+    JobDeque deque(4); // Has to grow
+
+    for (size_t i = 0; i < items.size(); ++i) deque.Push(fakeJob(items, i));
+    check(deque.Size() == 100, "deque order", "size after pushes");
+    check(deque.Steal() == fakeJob(items, 0), "deque order", "steal takes the oldest job");
+    check(deque.Pop() == fakeJob(items, 99), "deque order", "pop takes the newest job");
+
+    size_t left = 0;
+    while (deque.Pop()) left++;
+    check(left == 98, "deque order", "every remaining job popped");
+    check(deque.Pop() == nullptr && deque.Steal() == nullptr, "deque order", "empty deque returns nullptr");
+  }
+
+  // Owner pushes and pops while thieves steal, every job has to come out exactly once
+  void testDequeConcurrent() {
+    constexpr size_t Count = 200000, Thieves = 3;
+    std::vector<char> items(Count);
+    std::vector<std::atomic<int>> seen(Count);
+    JobDeque deque(8);
+    std::atomic<bool> done{ false };
+
+    std::vector<std::thread> thieves{};
+    for (size_t t = 0; t < Thieves; ++t) {
+      thieves.emplace_back([&]() {
+        while (!done.load(std::memory_order_acquire) || deque.Size() > 0)
+          if (Job *job = deque.Steal()) seen[fakeIndex(items, job)].fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+
+    for (size_t i = 0; i < Count; ++i) {
+      deque.Push(fakeJob(items, i));
+      if (i % 3 == 0)
+        if (Job *job = deque.Pop()) seen[fakeIndex(items, job)].fetch_add(1, std::memory_order_relaxed);
+    }
+    while (Job *job = deque.Pop()) seen[fakeIndex(items, job)].fetch_add(1, std::memory_order_relaxed);
+    done.store(true, std::memory_order_release);
+    for (auto &thief : thieves) thief.join();
+
+    size_t wrong = 0;
+    for (auto &count : seen) if (count.load() != 1) wrong++;
+    check(wrong == 0, "deque concurrent", "every job taken exactly once");
+  }
+
+  struct OrderLog {
+    std::atomic<int> Next{ 0 };
+    std::vector<int> Order;
+    OrderLog(size_t count) : Order(count, -1) {}
+  };
+
+  struct OrderArg {
+    OrderLog *Log;
+    size_t Index;
+  };
+
+  void record(void *arg) {
+    auto &order = *(OrderArg*)arg;
+    order.Log->Order[order.Index] = order.Log->Next.fetch_add(1);
+  }
+
+  // Chain submitted back to front, so only the dependencies can enforce the order
+  void testDependencyChain(JobSystem &system) {
+    constexpr size_t Count = 64;
+    OrderLog log(Count);
+    std::vector<OrderArg> args(Count);
+    std::vector<Job*> jobs(Count);
+    for (size_t i = 0; i < Count; ++i) {
+      args[i] = { &log, i };
+      jobs[i] = system.Create(record, &args[i]);
+      if (i > 0) system.DependsOn(jobs[i], jobs[i - 1]);
+    }
+    for (size_t i = Count; i-- > 0;) system.Submit(jobs[i]);
+    system.Wait(jobs[Count - 1]);
+    for (auto job : jobs) system.Release(job);
+
+    bool ordered = true;
+    for (size_t i = 0; i < Count; ++i) ordered = ordered && log.Order[i] == (int)i;
+    check(ordered, "dependency chain", "jobs ran in dependency order");
+  }
+
+  // a -> b, c -> d
+  void testDependencyDiamond(JobSystem &system) {
+    for (int round = 0; round < 200; ++round) {
+      OrderLog log(4);
+      OrderArg args[4] = { { &log, 0 }, { &log, 1 }, { &log, 2 }, { &log, 3 } };
+      Job *a = system.Create(record, &args[0]), *b = system.Create(record, &args[1]);
+      Job *c = system.Create(record, &args[2]), *d = system.Create(record, &args[3]);
+      system.DependsOn(b, a);
+      system.DependsOn(c, a);
+      system.DependsOn(d, b);
+      system.DependsOn(d, c);
+      system.Submit(d);
+      system.Submit(c);
+      system.Submit(b);
+      system.Submit(a);
+      system.Wait(d);
+      for (auto job : { a, b, c, d }) system.Release(job);
+
+      bool ordered = log.Order[0] == 0 && log.Order[3] == 3;
+      check(ordered, "dependency diamond", "a first, d last");
+      if (!ordered) return;
+    }
+  }
+
+  void increment(void *arg) { ((std::atomic<int>*)arg)->fetch_add(1, std::memory_order_relaxed); }
+  void nothing(void *) {}
+
+  // Waiting on a parent waits for all of its children
+  void testChildren(JobSystem &system) {
+    std::atomic<int> count{ 0 };
+    Job *parent = system.Create(nothing, nullptr);
+    std::vector<Job*> children{};
+    for (int i = 0; i < 256; ++i) {
+      children.push_back(system.Create(increment, &count, parent));
+      system.Submit(children.back());
+    }
+    system.Submit(parent);
+    system.Wait(parent);
+    check(count.load() == 256, "children", "parent finished after all children");
+    for (auto child : children) system.Release(child);
+    system.Release(parent);
+  }
+
+  struct Grid {
+    JobSystem *System;
+    int64_t Size;
+    std::vector<std::atomic<int>> Hits;
+    Grid(JobSystem *system, int64_t size) : System(system), Size(size), Hits(size * size) {}
+  };
+
+  struct Row {
+    Grid *Cells;
+    int64_t Index;
+  };
+
+  void visitColumns(int64_t begin, int64_t end, void *arg) {
+    auto &row = *(Row*)arg;
+    for (int64_t j = begin; j < end; ++j) row.Cells->Hits[row.Index * row.Cells->Size + j].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void visitRows(int64_t begin, int64_t end, void *arg) {
+    auto &grid = *(Grid*)arg;
+    for (int64_t i = begin; i < end; ++i) {
+      Row row{ &grid, i };
+      grid.System->ParallelFor(0, grid.Size, visitColumns, &row, 1);
+    }
+  }
+
+  void testNestedParallelFor(JobSystem &system) {
+    Grid grid(&system, 96);
+    system.ParallelFor(0, grid.Size, visitRows, &grid, 1);
+
+    size_t wrong = 0;
+    for (auto &hits : grid.Hits) if (hits.load() != 1) wrong++;
+    check(wrong == 0, "nested parallel_for", "every cell visited exactly once");
+  }
+
+  std::atomic<int> g_Spawned{ 0 };
+
+  void spawnedLeaf(void *) { g_Spawned.fetch_add(1, std::memory_order_relaxed); }
+
+  // Spawns and joins from inside a spawned job
+  void spawnedInner(void *) {
+    void *handles[4];
+    for (auto &handle : handles) handle = ulang_spawn(spawnedLeaf, nullptr);
+    for (auto handle : handles) ulang_join(handle);
+    g_Spawned.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void testSpawnJoin() {
+    std::vector<void*> handles{};
+    for (int i = 0; i < 128; ++i) handles.push_back(ulang_spawn(i % 2 ? spawnedInner : spawnedLeaf, nullptr));
+    for (auto handle : handles) ulang_join(handle);
+    check(g_Spawned.load() == 64 + 64 * 5, "spawn/join", "every spawned job ran before its join returned");
+  }
+
+}
+
+int main(int argc, char **argv) {
+  size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+
+  testDequeOrder();
+  testDequeConcurrent();
+  {
+    JobSystem system(threads);
+    testDependencyChain(system);
+    testDependencyDiamond(system);
+    testChildren(system);
+    testNestedParallelFor(system);
+  }
+
+  ulang_jobs_init((int64_t)threads);
+  testSpawnJoin();
+
+  std::printf("%s (%zu threads)\n", g_Failures ? "jobs tests failed" : "jobs tests passed", threads);
+  return g_Failures ? 1 : 0;
+}
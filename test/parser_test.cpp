@@ -0,0 +1,59 @@
+// Tests for the diagnostics and panic-mode recovery of the lexer and parser.
+// Usage: ulang_parser_test
+#include <parser.h>
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+using namespace UraniumLang;
+
+namespace {
+
+  int g_Failures = 0;
+
+  struct Expected {
+    int Line, Column;
+  };
+
+  // Parses source and checks the position of every diagnostic and how many statements survived
+  void check(const char *test, const char *source, std::vector<Expected> expected, size_t statements) {
+    Parser parser(std::make_unique<Lexer>(std::make_unique<std::istringstream>(source)));
+    auto prog = parser.Parse();
+    auto &diags = parser.GetDiagnostics();
+
+    bool ok = diags.size() == expected.size() && prog->GetStatements().size() == statements;
+    for (size_t i = 0; ok && i < diags.size(); ++i)
+      ok = diags[i].Line == expected[i].Line && diags[i].Column == expected[i].Column;
+    if (ok) return;
+
+    std::printf("  FAILED %s: expected %zu diagnostic(s) and %zu statement(s), got %zu statement(s) and:\n",
+                test, expected.size(), statements, prog->GetStatements().size());
+    for (auto &diag : diags) std::printf("    %d:%d: %s\n", diag.Line, diag.Column, diag.Message.c_str());
+    g_Failures++;
+  }
+
+}
+
+int main() {
+  check("valid program", "double a = 1;\ndouble b = a + 2;\n", {}, 2);
+
+  check("broken statement", "double a = ;\ndouble b = 2;\n", { { 1, 12 } }, 1);
+  check("broken statements", "double a = ;\ndouble b = * 2;\ndouble c = 3;\n", { { 1, 12 }, { 2, 12 } }, 1);
+  check("broken expression statement", "a = 1 +;\ndouble b = 2;\n", { { 1, 8 } }, 1);
+
+  // Only the broken inner statement is dropped, the scopes around it are kept
+  check("error in nested braces", "{\n  {\n    double a = 1 +;\n  }\n  double b = 2;\n}\ndouble c = 3;\n", { { 3, 19 } }, 2);
+  check("error before nested braces", "for (i = 0 : ) {\n  { double a = 1; }\n}\ndouble c = 3;\n", { { 1, 14 } }, 1);
+
+  check("stray brace", "double a = 1;\n}\ndouble b = 2;\n", { { 2, 1 } }, 2);
+  check("stray brace in scope", "{\n  double a = 1;\n  }\n}\ndouble b = 2;\n", { { 4, 1 } }, 2);
+
+  // The lexer reports bad char literals, the parser doesn't add more for the same token
+  check("long char literal", "double c = 'ab';\ndouble d = 1;\n", { { 1, 14 } }, 1);
+  check("empty char literal", "double c = '';\ndouble d = 1;\n", { { 1, 12 } }, 1);
+  check("unterminated char literal", "double c = 'a\ndouble d = 1;\ndouble e = 2;\n", { { 1, 12 } }, 1);
+
+  std::printf("%s\n", g_Failures ? "parser tests failed" : "parser tests passed");
+  return g_Failures ? 1 : 0;
+}